@@ -0,0 +1,233 @@
+#include "AesCipher.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PYINST_AES_X86 1
+#include <immintrin.h>
+#include <wmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PYINST_TARGET_AES __attribute__((target("aes,sse2")))
+#else
+#define PYINST_TARGET_AES
+#endif
+
+namespace {
+
+const uint8_t SBOX[256] = {
+    0x63, 0x7c, 0x77, 0x7b, 0xf2, 0x6b, 0x6f, 0xc5, 0x30, 0x01, 0x67, 0x2b, 0xfe, 0xd7, 0xab, 0x76,
+    0xca, 0x82, 0xc9, 0x7d, 0xfa, 0x59, 0x47, 0xf0, 0xad, 0xd4, 0xa2, 0xaf, 0x9c, 0xa4, 0x72, 0xc0,
+    0xb7, 0xfd, 0x93, 0x26, 0x36, 0x3f, 0xf7, 0xcc, 0x34, 0xa5, 0xe5, 0xf1, 0x71, 0xd8, 0x31, 0x15,
+    0x04, 0xc7, 0x23, 0xc3, 0x18, 0x96, 0x05, 0x9a, 0x07, 0x12, 0x80, 0xe2, 0xeb, 0x27, 0xb2, 0x75,
+    0x09, 0x83, 0x2c, 0x1a, 0x1b, 0x6e, 0x5a, 0xa0, 0x52, 0x3b, 0xd6, 0xb3, 0x29, 0xe3, 0x2f, 0x84,
+    0x53, 0xd1, 0x00, 0xed, 0x20, 0xfc, 0xb1, 0x5b, 0x6a, 0xcb, 0xbe, 0x39, 0x4a, 0x4c, 0x58, 0xcf,
+    0xd0, 0xef, 0xaa, 0xfb, 0x43, 0x4d, 0x33, 0x85, 0x45, 0xf9, 0x02, 0x7f, 0x50, 0x3c, 0x9f, 0xa8,
+    0x51, 0xa3, 0x40, 0x8f, 0x92, 0x9d, 0x38, 0xf5, 0xbc, 0xb6, 0xda, 0x21, 0x10, 0xff, 0xf3, 0xd2,
+    0xcd, 0x0c, 0x13, 0xec, 0x5f, 0x97, 0x44, 0x17, 0xc4, 0xa7, 0x7e, 0x3d, 0x64, 0x5d, 0x19, 0x73,
+    0x60, 0x81, 0x4f, 0xdc, 0x22, 0x2a, 0x90, 0x88, 0x46, 0xee, 0xb8, 0x14, 0xde, 0x5e, 0x0b, 0xdb,
+    0xe0, 0x32, 0x3a, 0x0a, 0x49, 0x06, 0x24, 0x5c, 0xc2, 0xd3, 0xac, 0x62, 0x91, 0x95, 0xe4, 0x79,
+    0xe7, 0xc8, 0x37, 0x6d, 0x8d, 0xd5, 0x4e, 0xa9, 0x6c, 0x56, 0xf4, 0xea, 0x65, 0x7a, 0xae, 0x08,
+    0xba, 0x78, 0x25, 0x2e, 0x1c, 0xa6, 0xb4, 0xc6, 0xe8, 0xdd, 0x74, 0x1f, 0x4b, 0xbd, 0x8b, 0x8a,
+    0x70, 0x3e, 0xb5, 0x66, 0x48, 0x03, 0xf6, 0x0e, 0x61, 0x35, 0x57, 0xb9, 0x86, 0xc1, 0x1d, 0x9e,
+    0xe1, 0xf8, 0x98, 0x11, 0x69, 0xd9, 0x8e, 0x94, 0x9b, 0x1e, 0x87, 0xe9, 0xce, 0x55, 0x28, 0xdf,
+    0x8c, 0xa1, 0x89, 0x0d, 0xbf, 0xe6, 0x42, 0x68, 0x41, 0x99, 0x2d, 0x0f, 0xb0, 0x54, 0xbb, 0x16
+};
+
+const uint8_t RCON[10] = { 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80, 0x1b, 0x36 };
+
+inline uint8_t xtime(uint8_t x) {
+    return static_cast<uint8_t>((x << 1) ^ ((x & 0x80) ? 0x1b : 0x00));
+}
+
+/**
+ * @brief Encrypts one block with the portable byte-oriented implementation.
+ */
+void encryptBlockPortable(const uint8_t* roundKeys, const uint8_t* in, uint8_t* out) {
+    uint8_t s[AES_BLOCK_SIZE];
+    for (size_t i = 0; i < AES_BLOCK_SIZE; ++i) {
+        s[i] = in[i] ^ roundKeys[i];
+    }
+    for (int round = 1; round <= 10; ++round) {
+        // SubBytes and ShiftRows; the state is column-major
+        uint8_t t[AES_BLOCK_SIZE];
+        for (int c = 0; c < 4; ++c) {
+            for (int r = 0; r < 4; ++r) {
+                t[4 * c + r] = SBOX[s[4 * ((c + r) % 4) + r]];
+            }
+        }
+        // MixColumns, skipped in the last round
+        if (round < 10) {
+            for (int c = 0; c < 4; ++c) {
+                uint8_t* col = t + 4 * c;
+                uint8_t all = col[0] ^ col[1] ^ col[2] ^ col[3];
+                uint8_t first = col[0];
+                col[0] ^= all ^ xtime(col[0] ^ col[1]);
+                col[1] ^= all ^ xtime(col[1] ^ col[2]);
+                col[2] ^= all ^ xtime(col[2] ^ col[3]);
+                col[3] ^= all ^ xtime(col[3] ^ first);
+            }
+        }
+        const uint8_t* key = roundKeys + round * AES_BLOCK_SIZE;
+        for (size_t i = 0; i < AES_BLOCK_SIZE; ++i) {
+            s[i] = t[i] ^ key[i];
+        }
+    }
+    std::memcpy(out, s, AES_BLOCK_SIZE);
+}
+
+#ifdef PYINST_AES_X86
+/**
+ * @brief Encrypts blocks with AES-NI, four at a time to hide the instruction latency.
+ */
+PYINST_TARGET_AES
+void encryptBlocksAesni(const uint8_t* roundKeys, const uint8_t* in, uint8_t* out, size_t blocks) {
+    __m128i keys[11];
+    for (int i = 0; i < 11; ++i) {
+        keys[i] = _mm_load_si128(reinterpret_cast<const __m128i*>(roundKeys) + i);
+    }
+    size_t i = 0;
+    for (; i + 4 <= blocks; i += 4) {
+        const __m128i* src = reinterpret_cast<const __m128i*>(in) + i;
+        __m128i b0 = _mm_xor_si128(_mm_loadu_si128(src), keys[0]);
+        __m128i b1 = _mm_xor_si128(_mm_loadu_si128(src + 1), keys[0]);
+        __m128i b2 = _mm_xor_si128(_mm_loadu_si128(src + 2), keys[0]);
+        __m128i b3 = _mm_xor_si128(_mm_loadu_si128(src + 3), keys[0]);
+        for (int round = 1; round < 10; ++round) {
+            b0 = _mm_aesenc_si128(b0, keys[round]);
+            b1 = _mm_aesenc_si128(b1, keys[round]);
+            b2 = _mm_aesenc_si128(b2, keys[round]);
+            b3 = _mm_aesenc_si128(b3, keys[round]);
+        }
+        __m128i* dst = reinterpret_cast<__m128i*>(out) + i;
+        _mm_storeu_si128(dst, _mm_aesenclast_si128(b0, keys[10]));
+        _mm_storeu_si128(dst + 1, _mm_aesenclast_si128(b1, keys[10]));
+        _mm_storeu_si128(dst + 2, _mm_aesenclast_si128(b2, keys[10]));
+        _mm_storeu_si128(dst + 3, _mm_aesenclast_si128(b3, keys[10]));
+    }
+    for (; i < blocks; ++i) {
+        __m128i b = _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(in) + i), keys[0]);
+        for (int round = 1; round < 10; ++round) {
+            b = _mm_aesenc_si128(b, keys[round]);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(out) + i, _mm_aesenclast_si128(b, keys[10]));
+    }
+}
+
+/**
+ * @brief Detects at runtime whether the CPU supports the AES-NI instructions.
+ */
+bool cpuHasAesni() {
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 1);
+    return (regs[2] & (1 << 25)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("aes") != 0;
+#endif
+}
+#endif // PYINST_AES_X86
+
+} // namespace
+
+/**
+ * @brief Expands an AES-128 key.
+ *
+ * The schedule is computed in software; its byte layout is the one the
+ * AES-NI round instructions expect, so both paths share it.
+ *
+ * @param key The 16-byte key.
+ */
+AesCipher::AesCipher(const uint8_t key[AES_BLOCK_SIZE]) {
+    std::memcpy(roundKeys, key, AES_BLOCK_SIZE);
+    for (size_t i = 4; i < 44; ++i) {
+        uint8_t word[4];
+        std::memcpy(word, roundKeys + 4 * (i - 1), 4);
+        if (i % 4 == 0) {
+            uint8_t first = word[0];
+            word[0] = SBOX[word[1]] ^ RCON[i / 4 - 1];
+            word[1] = SBOX[word[2]];
+            word[2] = SBOX[word[3]];
+            word[3] = SBOX[first];
+        }
+        for (size_t j = 0; j < 4; ++j) {
+            roundKeys[4 * i + j] = roundKeys[4 * (i - 4) + j] ^ word[j];
+        }
+    }
+#ifdef PYINST_AES_X86
+    static const bool hasAesni = cpuHasAesni();
+    useAesni = hasAesni;
+#else
+    useAesni = false;
+#endif
+}
+
+/**
+ * @brief Encrypts consecutive 16-byte blocks independently (ECB).
+ *
+ * @param in Plaintext blocks.
+ * @param out Ciphertext blocks; may equal `in`.
+ * @param blocks Number of blocks.
+ */
+void AesCipher::encryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks) const {
+#ifdef PYINST_AES_X86
+    if (useAesni) {
+        encryptBlocksAesni(roundKeys, in, out, blocks);
+        return;
+    }
+#endif
+    for (size_t i = 0; i < blocks; ++i) {
+        encryptBlockPortable(roundKeys, in + i * AES_BLOCK_SIZE, out + i * AES_BLOCK_SIZE);
+    }
+}
+
+AesDecryptor::AesDecryptor(const AesCipher& cipher, AesMode mode, const uint8_t iv[AES_BLOCK_SIZE])
+    : cipher(cipher), mode(mode), keystream(), keystreamPos(0), keystreamLen(0) {
+    std::memcpy(state, iv, AES_BLOCK_SIZE);
+}
+
+/**
+ * @brief Decrypts the next part of the stream.
+ *
+ * CTR treats the IV as a 128-bit big-endian counter and encrypts several
+ * counter blocks per call, so the AES-NI path can pipeline them. CFB-8 is
+ * inherently serial and encrypts the shift register once per byte.
+ *
+ * @param in Ciphertext.
+ * @param out Plaintext; may equal `in`.
+ * @param len Number of bytes.
+ */
+void AesDecryptor::process(const uint8_t* in, uint8_t* out, size_t len) {
+    if (mode == AesMode::Cfb8) {
+        uint8_t block[AES_BLOCK_SIZE];
+        for (size_t i = 0; i < len; ++i) {
+            cipher.encryptBlocks(state, block, 1);
+            uint8_t c = in[i];
+            out[i] = c ^ block[0];
+            std::memmove(state, state + 1, AES_BLOCK_SIZE - 1);
+            state[AES_BLOCK_SIZE - 1] = c;
+        }
+        return;
+    }
+
+    for (size_t i = 0; i < len; ++i) {
+        if (keystreamPos == keystreamLen) {
+            for (size_t b = 0; b < BATCH_BLOCKS; ++b) {
+                std::memcpy(keystream + b * AES_BLOCK_SIZE, state, AES_BLOCK_SIZE);
+                for (size_t j = AES_BLOCK_SIZE; j-- > 0;) {
+                    if (++state[j] != 0) {
+                        break;
+                    }
+                }
+            }
+            cipher.encryptBlocks(keystream, keystream, BATCH_BLOCKS);
+            keystreamPos = 0;
+            keystreamLen = sizeof(keystream);
+        }
+        out[i] = in[i] ^ keystream[keystreamPos++];
+    }
+}
@@ -0,0 +1,54 @@
+#ifndef AESCIPHER_H
+#define AESCIPHER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Size of an AES block and of an AES-128 key
+const size_t AES_BLOCK_SIZE = 16;
+
+// Stream modes PyInstaller has used for encrypted PYZ modules
+enum class AesMode {
+    Ctr,                           // tinyaes CTR, PyInstaller 4.0 to 5.x
+    Cfb8                           // PyCrypto's default 8-bit CFB, PyInstaller 3.x
+};
+
+// AES-128 encryption of single blocks, using AES-NI when the CPU supports it
+class AesCipher {
+public:
+    // Constructor
+    explicit AesCipher(const uint8_t key[AES_BLOCK_SIZE]);
+
+    // Member functions
+    void encryptBlocks(const uint8_t* in, uint8_t* out, size_t blocks) const;
+
+    bool isHardwareAccelerated() const {
+        return useAesni;
+    }
+
+private:
+    alignas(16) uint8_t roundKeys[11 * AES_BLOCK_SIZE]; // Expanded key schedule
+    bool useAesni;                 // Whether to use the AES-NI path
+};
+
+// Decrypts one CTR or CFB-8 stream chunk by chunk
+class AesDecryptor {
+public:
+    // Constructor
+    AesDecryptor(const AesCipher& cipher, AesMode mode, const uint8_t iv[AES_BLOCK_SIZE]);
+
+    // Member functions
+    void process(const uint8_t* in, uint8_t* out, size_t len);
+
+private:
+    static const size_t BATCH_BLOCKS = 8;
+
+    const AesCipher& cipher;       // Block cipher
+    AesMode mode;                  // Stream mode
+    uint8_t state[AES_BLOCK_SIZE]; // Counter (CTR) or shift register (CFB-8)
+    uint8_t keystream[BATCH_BLOCKS * AES_BLOCK_SIZE]; // Unused CTR keystream
+    size_t keystreamPos;           // Next unused keystream byte
+    size_t keystreamLen;           // Valid keystream bytes
+};
+
+#endif // AESCIPHER_H
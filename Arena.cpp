@@ -0,0 +1,43 @@
+#include "Arena.h"
+#include <algorithm>
+
+Arena::Arena(size_t blockSize)
+    : blockSize(std::max<size_t>(blockSize, 256)), cursor(nullptr), remaining(0), bytesUsed(0) {}
+
+/**
+ * @brief Allocates memory that lives until the arena is reset or destroyed.
+ *
+ * Requests are carved out of the current block; when it is exhausted a new
+ * block is allocated, sized to fit oversized requests.
+ *
+ * @param size Number of bytes.
+ * @param alignment Required alignment, a power of two.
+ * @return Pointer to the memory.
+ */
+void* Arena::allocate(size_t size, size_t alignment) {
+    size_t padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+    if (cursor == nullptr || padding + size > remaining) {
+        size_t capacity = std::max(blockSize, size + alignment);
+        blocks.emplace_back(new uint8_t[capacity]);
+        cursor = blocks.back().get();
+        remaining = capacity;
+        padding = (alignment - reinterpret_cast<uintptr_t>(cursor) % alignment) % alignment;
+    }
+    uint8_t* result = cursor + padding;
+    cursor += padding + size;
+    remaining -= padding + size;
+    bytesUsed += size;
+    return result;
+}
+
+/**
+ * @brief Releases every allocation, keeping the first block for reuse.
+ */
+void Arena::reset() {
+    if (blocks.size() > 1) {
+        blocks.erase(blocks.begin() + 1, blocks.end());
+    }
+    cursor = blocks.empty() ? nullptr : blocks.front().get();
+    remaining = blocks.empty() ? 0 : blockSize;
+    bytesUsed = 0;
+}
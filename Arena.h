@@ -0,0 +1,55 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Bump allocator for short-lived object graphs that are released all at once
+class Arena {
+public:
+    // Constructor
+    explicit Arena(size_t blockSize = 64 * 1024);
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    // Member functions
+    void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+    void reset();
+
+    // Constructs an object in the arena; destructors never run, so only trivial types are allowed
+    template <typename T, typename... Args>
+    T* create(Args&&... args) {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+        return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+    }
+
+    // Allocates an uninitialized array of trivial objects
+    template <typename T>
+    T* allocateArray(size_t count) {
+        static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+        return static_cast<T*>(allocate(sizeof(T) * count, alignof(T)));
+    }
+
+    size_t getBytesUsed() const {
+        return bytesUsed;
+    }
+
+    size_t getBlockCount() const {
+        return blocks.size();
+    }
+
+private:
+    size_t blockSize;              // Size of regular blocks
+    std::vector<std::unique_ptr<uint8_t[]>> blocks; // Every block allocated so far
+    uint8_t* cursor;               // Next free byte in the current block
+    size_t remaining;              // Free bytes left in the current block
+    size_t bytesUsed;              // Bytes handed out since the last reset
+};
+
+#endif // ARENA_H
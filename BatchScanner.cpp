@@ -0,0 +1,231 @@
+#include "BatchScanner.h"
+#include "PyInstArchive.h"
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+/**
+ * @brief Identifies one file and, for archives, reads the cookie and the TOC.
+ *
+ * @param path File to scan.
+ * @param useMmap Whether to map the file.
+ * @param result Receives the classification and archive metadata.
+ */
+void scanFile(const std::string& path, bool useMmap, ScanResult& result) {
+    result.path = path;
+    PyInstArchive archive(path, useMmap);
+    if (!archive.open()) {
+        result.status = ScanStatus::Unreadable;
+        return;
+    }
+    if (!archive.checkFile()) {
+        result.status = ScanStatus::NotArchive;
+        result.fileSize = archive.getArchiveInfo().fileSize;
+        return;
+    }
+    bool parsed = archive.getCArchiveInfo();
+    ArchiveInfo info = archive.getArchiveInfo();
+    result.status = parsed ? ScanStatus::Archive : ScanStatus::Corrupt;
+    result.fileSize = info.fileSize;
+    result.pyinstVer = info.pyinstVer;
+    if (!parsed) {
+        return;
+    }
+    result.pymaj = info.pymaj;
+    result.pymin = info.pymin;
+    result.overlayPos = info.overlayPos;
+    result.overlaySize = info.overlaySize;
+    result.entries = info.entries->size();
+    for (uint32_t size : info.entries->uncompressedSizes()) {
+        result.uncompressedSize += size;
+    }
+}
+
+/**
+ * @brief Classifies one file with triageFile() only.
+ *
+ * @param path File to check.
+ * @param options Settings of the triage.
+ * @param result Receives the verdict and the cookie metadata.
+ */
+void triageInto(const std::string& path, const TriageOptions& options, ScanResult& result) {
+    TriageResult triage = triageFile(path, options);
+    result.path = path;
+    result.format = triage.format;
+    result.fileSize = triage.fileSize;
+    result.pyinstVer = triage.pyinstVer;
+    result.pymaj = triage.pymaj;
+    result.pymin = triage.pymin;
+    result.overlayPos = triage.overlayPos;
+    result.overlaySize = triage.overlaySize;
+    switch (triage.verdict) {
+    case TriageVerdict::PyInstaller:
+        result.status = ScanStatus::Archive;
+        break;
+    case TriageVerdict::NotPyInstaller:
+        result.status = ScanStatus::NotArchive;
+        break;
+    case TriageVerdict::Corrupt:
+        result.status = ScanStatus::Corrupt;
+        break;
+    case TriageVerdict::Unreadable:
+        result.status = ScanStatus::Unreadable;
+        break;
+    }
+}
+
+} // namespace
+
+BatchScanner::BatchScanner(const BatchOptions& options)
+    : options(options) {}
+
+/**
+ * @brief Queues a file, or every regular file below a directory.
+ *
+ * Directories are walked once up front, recording file sizes for scheduling.
+ * Symbolic links to directories are not followed. A directory that cannot be
+ * opened or listed completely is logged and queued as an unreadable result,
+ * and the walk continues with the remaining directories.
+ *
+ * @param path File or directory.
+ * @return true if the path exists, false otherwise.
+ */
+bool BatchScanner::addPath(const std::string& path) {
+    std::filesystem::path root = std::filesystem::u8path(path);
+    std::error_code ec;
+    std::filesystem::file_status status = std::filesystem::status(root, ec);
+    if (ec || !std::filesystem::exists(status)) {
+        logError("Could not find ", path);
+        return false;
+    }
+    if (!std::filesystem::is_directory(status)) {
+        files.push_back(path);
+        sizes.push_back(std::filesystem::file_size(root, ec));
+        unlisted.push_back(false);
+        return true;
+    }
+
+    std::vector<std::filesystem::path> pending = { root };
+    while (!pending.empty()) {
+        std::filesystem::path dir = std::move(pending.back());
+        pending.pop_back();
+        std::filesystem::directory_iterator it(dir, ec), end;
+        for (; !ec && it != end; it.increment(ec)) {
+            std::error_code entryError;
+            if (options.recursive && it->is_directory(entryError) && !it->is_symlink(entryError)) {
+                pending.push_back(it->path());
+            }
+            else if (it->is_regular_file(entryError)) {
+                files.push_back(it->path().u8string());
+                uint64_t size = it->file_size(entryError);
+                sizes.push_back(entryError ? 0 : size);
+                unlisted.push_back(false);
+            }
+        }
+        if (ec) {
+            logError("Could not list ", dir.u8string(), ": ", ec.message());
+            files.push_back(dir.u8string());
+            sizes.push_back(0);
+            unlisted.push_back(true);
+            ec.clear();
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Queues the files and directories listed in a text file, one path per line.
+ *
+ * @param listFile Path of the list.
+ * @return true if the list was read, false if it could not be opened.
+ */
+bool BatchScanner::addFileList(const std::string& listFile) {
+    std::ifstream in(std::filesystem::u8path(listFile));
+    if (!in) {
+        logError("Could not open ", listFile);
+        return false;
+    }
+    std::string line;
+    while (std::getline(in, line)) {
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (!line.empty()) {
+            addPath(line);
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Scans every queued file on a pool of worker threads.
+ *
+ * Each file gets its own PyInstArchive, opened, checked and parsed up to the
+ * TOC on a worker, so the cost per file is a few reads rather than a process
+ * start. At most `options.threads` files are open at once. Files are
+ * dispatched largest first since a full backward scan of a non-archive costs
+ * time proportional to its size. Per-file log output uses
+ * `options.fileLogLevel`, off by default, as failures are reported in the
+ * results. With `options.triageOnly` each file only gets the header and tail
+ * reads of triageFile(). Directories that could not be listed are reported
+ * as unreadable without a scan. The queue is emptied afterwards.
+ *
+ * @return The results, in the order the files were queued.
+ */
+const std::vector<ScanResult>& BatchScanner::run() {
+    results.assign(files.size(), ScanResult());
+    summary = BatchSummary();
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(options.threads);
+        for (size_t i = 0; i < files.size(); ++i) {
+            if (unlisted[i]) {
+                results[i].path = files[i];
+                continue;
+            }
+            pool.submit([this, i] {
+                ScopedThreadLogLevel logLevel(options.fileLogLevel);
+                if (options.triageOnly) {
+                    triageInto(files[i], options.triage, results[i]);
+                }
+                else {
+                    scanFile(files[i], options.useMmap, results[i]);
+                }
+            }, sizes[i]);
+        }
+        pool.wait();
+        summary.workers = pool.getWorkerStats();
+    }
+    summary.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (const ScanResult& result : results) {
+        ++summary.files;
+        summary.bytes += result.fileSize;
+        switch (result.status) {
+        case ScanStatus::Archive:
+            ++summary.archives;
+            ++summary.pythonVersions[std::to_string(result.pymaj) + "." + std::to_string(result.pymin)];
+            break;
+        case ScanStatus::NotArchive:
+            ++summary.notArchives;
+            break;
+        case ScanStatus::Corrupt:
+            ++summary.corrupt;
+            break;
+        case ScanStatus::Unreadable:
+            ++summary.unreadable;
+            break;
+        }
+    }
+    files.clear();
+    sizes.clear();
+    unlisted.clear();
+
+    logInfo("Scanned ", summary.files, " files (", summary.bytes, " bytes) in ", summary.wallSeconds, " s: ",
+        summary.archives, " archives, ", summary.notArchives, " other files, ", summary.corrupt, " corrupt, ",
+        summary.unreadable, " unreadable");
+    return results;
+}
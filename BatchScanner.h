@@ -0,0 +1,87 @@
+#ifndef BATCHSCANNER_H
+#define BATCHSCANNER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <map>
+#include <string>
+#include <vector>
+#include "Logger.h"
+#include "ThreadPool.h"
+#include "Triage.h"
+
+// Classification of one scanned file
+enum class ScanStatus {
+    Archive,                       // PyInstaller CArchive, TOC parsed
+    NotArchive,                    // No cookie, not a PyInstaller file
+    Corrupt,                       // Cookie found but the CArchive could not be parsed
+    Unreadable                     // File could not be opened, or directory could not be listed
+};
+
+// Outcome of scanning one file
+struct ScanResult {
+    std::string path;              // Path of the file
+    ScanStatus status = ScanStatus::Unreadable; // Classification
+    ExecutableFormat format = ExecutableFormat::Unknown; // Executable format, set in triage mode
+    uint64_t fileSize = 0;         // Size of the file
+    uint8_t pyinstVer = 0;         // PyInstaller version (20 or 21)
+    uint8_t pymaj = 0;             // Python major version
+    uint8_t pymin = 0;             // Python minor version
+    uint64_t overlayPos = 0;       // Start of the CArchive
+    uint64_t overlaySize = 0;      // Size of the CArchive
+    size_t entries = 0;            // Number of TOC entries, not set in triage mode
+    uint64_t uncompressedSize = 0; // Sum of the uncompressed entry sizes
+};
+
+// Totals over all files of a run
+struct BatchSummary {
+    size_t files = 0;              // Files scanned
+    size_t archives = 0;           // PyInstaller archives found
+    size_t notArchives = 0;        // Files without a cookie
+    size_t corrupt = 0;            // Archives that could not be parsed
+    size_t unreadable = 0;         // Files or directories that could not be read
+    uint64_t bytes = 0;            // Total size of the scanned files
+    std::map<std::string, size_t> pythonVersions; // Archives per "major.minor"
+    double wallSeconds = 0;        // Wall time of the run
+    std::vector<WorkerStats> workers; // Per-thread task counts and utilization
+};
+
+// Settings for BatchScanner
+struct BatchOptions {
+    unsigned threads = 0;          // Files scanned at once, 0 for one per hardware thread
+    bool recursive = true;         // Descend into subdirectories of added directories
+    bool useMmap = true;           // Map files instead of reading them through a stream
+    LogLevel fileLogLevel = LogLevel::Off; // Log threshold while a file is scanned
+    bool triageOnly = false;       // Only run triageFile() on each file instead of parsing the TOC
+    TriageOptions triage;          // Settings of triage mode
+};
+
+// Scans many files for PyInstaller archives concurrently within one process
+class BatchScanner {
+public:
+    // Constructor
+    explicit BatchScanner(const BatchOptions& options = BatchOptions());
+
+    // Member functions
+    bool addPath(const std::string& path);
+    bool addFileList(const std::string& listFile);
+    const std::vector<ScanResult>& run();
+
+    const std::vector<ScanResult>& getResults() const {
+        return results;
+    }
+
+    const BatchSummary& getSummary() const {
+        return summary;
+    }
+
+private:
+    BatchOptions options;          // Settings of the scanner
+    std::vector<std::string> files; // Files queued for the next run
+    std::vector<uint64_t> sizes;   // Sizes of the queued files, used to schedule large ones first
+    std::vector<bool> unlisted;    // Set for queued directories that could not be listed
+    std::vector<ScanResult> results; // Results of the last run, in the order files were added
+    BatchSummary summary;          // Totals of the last run
+};
+
+#endif // BATCHSCANNER_H
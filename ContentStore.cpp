@@ -0,0 +1,189 @@
+#include "ContentStore.h"
+#include <algorithm>
+#include <fstream>
+#include <random>
+#include <sstream>
+
+ContentStore::ContentStore(const std::filesystem::path& root)
+    : root(root) {
+    std::random_device random;
+    std::ostringstream prefix;
+    prefix << std::hex << random() << random();
+    tempPrefix = prefix.str();
+}
+
+/**
+ * @brief Creates the store directories if they do not exist yet.
+ *
+ * @return true if the store is ready, false otherwise.
+ */
+bool ContentStore::open() {
+    std::error_code ec;
+    std::filesystem::create_directories(root / "objects", ec);
+    if (!ec) {
+        std::filesystem::create_directories(root / "tmp", ec);
+    }
+    return !ec;
+}
+
+/**
+ * @brief Returns where the object with a digest lives, fanned out by its first byte.
+ *
+ * @param digest Lowercase hex SHA-256.
+ * @return `<root>/objects/<first two digits>/<remaining digits>`.
+ */
+std::filesystem::path ContentStore::objectPath(const std::string& digest) const {
+    return root / "objects" / digest.substr(0, 2) / digest.substr(2);
+}
+
+/**
+ * @brief Returns a fresh temp file name inside the store.
+ *
+ * Temp files live on the same filesystem as the objects, so publishing
+ * one is a rename.
+ */
+std::filesystem::path ContentStore::tempPath() {
+    return root / "tmp" / (tempPrefix + "-" + std::to_string(tempCounter++));
+}
+
+/**
+ * @brief Moves a finished temp file to its object path.
+ *
+ * The rename is atomic, so readers never see a partial object. If another
+ * writer published the same digest first, its identical copy is kept and the
+ * temp file is discarded.
+ *
+ * @param tempFile A complete temp file from tempPath().
+ * @param digest SHA-256 of its contents.
+ * @return true if the object is in the store afterwards, false otherwise.
+ */
+bool ContentStore::publish(const std::filesystem::path& tempFile, const std::string& digest) {
+    std::filesystem::path target = objectPath(digest);
+    std::error_code ec;
+    std::filesystem::create_directories(target.parent_path(), ec);
+    std::filesystem::rename(tempFile, target, ec);
+    if (ec) {
+        bool present = std::filesystem::exists(target, ec);
+        std::filesystem::remove(tempFile, ec);
+        return present;
+    }
+    return true;
+}
+
+/**
+ * @brief Adds an output to the manifest of the current run. Thread-safe.
+ *
+ * @param name Path of the output relative to the output directory.
+ * @param digest SHA-256 of the output.
+ * @param size Size of the output.
+ * @param written Whether the object was new to the store.
+ */
+void ContentStore::record(std::string name, std::string digest, uint64_t size, bool written) {
+    if (written) {
+        ++objectsWritten;
+    }
+    else {
+        ++objectsReused;
+        bytesReused += size;
+    }
+    std::lock_guard<std::mutex> lock(manifestMutex);
+    entries.push_back(StoredEntry{ std::move(name), std::move(digest), size });
+}
+
+/**
+ * @brief Writes the manifest of the current run, sorted by name.
+ *
+ * Each line holds the digest, the size and the name separated by tabs, so the
+ * original tree can be rebuilt from the objects.
+ *
+ * @param file Destination of the manifest.
+ * @return true if the manifest was written, false otherwise.
+ */
+bool ContentStore::writeManifest(const std::filesystem::path& file) {
+    std::lock_guard<std::mutex> lock(manifestMutex);
+    std::sort(entries.begin(), entries.end(), [](const StoredEntry& a, const StoredEntry& b) {
+        return a.name < b.name;
+    });
+    std::ofstream out(file, std::ios::binary | std::ios::trunc);
+    for (const StoredEntry& entry : entries) {
+        out << entry.digest << '\t' << entry.size << '\t' << entry.name << '\n';
+    }
+    out.close();
+    return !out.fail();
+}
+
+StoreSink::StoreSink(ContentStore& store, std::string name)
+    : store(store), name(std::move(name)), size(0), failed(false) {}
+
+/**
+ * @brief Hashes and buffers bytes of the output.
+ *
+ * Outputs stay in memory up to MEMORY_LIMIT, so one that is already in the
+ * store costs no write at all. Larger ones are spilled to a temp file.
+ *
+ * @param data Bytes to append.
+ * @param len Number of bytes.
+ * @return true if the bytes were accepted, false otherwise.
+ */
+bool StoreSink::write(const uint8_t* data, size_t len) {
+    if (failed) {
+        return false;
+    }
+    hash.update(data, len);
+    size += len;
+    if (!spillSink && buffer.size() + len <= MEMORY_LIMIT) {
+        buffer.insert(buffer.end(), data, data + len);
+        return true;
+    }
+    if (!spillSink && !spill()) {
+        return false;
+    }
+    failed = !spillSink->write(data, len);
+    return !failed;
+}
+
+/**
+ * @brief Moves the buffered bytes to a new temp file that receives all further writes.
+ */
+bool StoreSink::spill() {
+    tempFile = store.tempPath();
+    spillSink = std::make_unique<FileSink>(tempFile);
+    failed = !spillSink->open() || !spillSink->write(buffer.data(), buffer.size());
+    std::vector<uint8_t>().swap(buffer);
+    return !failed;
+}
+
+/**
+ * @brief Adds the output to the store unless an object with its digest exists.
+ *
+ * @return true if the output is in the store and recorded, false otherwise.
+ */
+bool StoreSink::commit() {
+    std::string digest = hash.finishHex();
+    std::error_code ec;
+    bool present = std::filesystem::exists(store.objectPath(digest), ec);
+    if (spillSink) {
+        failed = !spillSink->commit() || failed;
+        spillSink.reset();
+    }
+    else if (!failed && !present) {
+        tempFile = store.tempPath();
+        FileSink sink(tempFile);
+        failed = !sink.open() || !sink.write(buffer.data(), buffer.size());
+        failed = !sink.commit() || failed;
+    }
+
+    bool stored = !failed;
+    if (!tempFile.empty()) {
+        if (stored && !present) {
+            stored = store.publish(tempFile, digest);
+        }
+        else {
+            std::filesystem::remove(tempFile, ec);
+        }
+    }
+    if (stored) {
+        store.record(name, digest, size, !present);
+    }
+    return stored;
+}
@@ -0,0 +1,90 @@
+#ifndef CONTENTSTORE_H
+#define CONTENTSTORE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <atomic>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "OutputSink.h"
+#include "Sha256.h"
+
+// Name of the manifest written to the output directory of a run
+const char* const STORE_MANIFEST_NAME = "store-manifest.tsv";
+
+// Output file recorded in the manifest of a ContentStore run
+struct StoredEntry {
+    std::string name;              // Path relative to the output directory, '/'-separated
+    std::string digest;            // SHA-256 of the contents, lowercase hex
+    uint64_t size;                 // Size of the contents
+};
+
+// Directory of extracted payloads stored once under their SHA-256, shared by many archives
+class ContentStore {
+public:
+    // Constructor
+    explicit ContentStore(const std::filesystem::path& root);
+
+    // Member functions
+    bool open();
+    std::filesystem::path objectPath(const std::string& digest) const;
+    std::filesystem::path tempPath();
+    bool publish(const std::filesystem::path& tempFile, const std::string& digest);
+    void record(std::string name, std::string digest, uint64_t size, bool written);
+    bool writeManifest(const std::filesystem::path& file);
+
+    size_t getObjectsWritten() const {
+        return objectsWritten;
+    }
+
+    size_t getObjectsReused() const {
+        return objectsReused;
+    }
+
+    uint64_t getBytesReused() const {
+        return bytesReused;
+    }
+
+private:
+    std::filesystem::path root;    // Store directory, holding objects/ and tmp/
+    std::string tempPrefix;        // Random prefix keeping temp names unique across processes
+    std::atomic<uint64_t> tempCounter{0}; // Next temp file number
+    std::mutex manifestMutex;      // Guards entries
+    std::vector<StoredEntry> entries; // Outputs of the current run
+    std::atomic<size_t> objectsWritten{0}; // New objects added to the store
+    std::atomic<size_t> objectsReused{0}; // Outputs already present in the store
+    std::atomic<uint64_t> bytesReused{0}; // Bytes of outputs already present
+};
+
+// Sink that hashes the output and adds it to a ContentStore on commit
+class StoreSink : public OutputSink {
+public:
+    // Constructor
+    StoreSink(ContentStore& store, std::string name);
+
+    StoreSink(const StoreSink&) = delete;
+    StoreSink& operator=(const StoreSink&) = delete;
+
+    // Member functions
+    bool write(const uint8_t* data, size_t len) override;
+    bool commit() override;
+
+private:
+    bool spill();
+
+    ContentStore& store;           // Destination store
+    std::string name;              // Manifest name of the output
+    Sha256 hash;                   // Digest of the bytes written so far
+    uint64_t size;                 // Bytes written so far
+    std::vector<uint8_t> buffer;   // Output kept in memory while it is small
+    std::filesystem::path tempFile; // Spill file once the output outgrows the buffer
+    std::unique_ptr<FileSink> spillSink; // Writer of tempFile
+    bool failed;                   // Set when a write failed
+
+    static const size_t MEMORY_LIMIT = 4 * 1024 * 1024;
+};
+
+#endif // CONTENTSTORE_H
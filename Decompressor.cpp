@@ -0,0 +1,161 @@
+#include "Decompressor.h"
+#include <zlib.h>
+#include <algorithm>
+#include <climits>
+#include <vector>
+
+#ifdef PYINST_WITH_LIBDEFLATE
+#include <libdeflate.h>
+#endif
+
+/**
+ * @brief Inflates a zlib stream incrementally, holding at most one output chunk in memory.
+ *
+ * Compressed input is pulled from `source` as needed and every filled output
+ * chunk is handed to `sink`, so memory use stays constant no matter how large
+ * the entry is. The default implementation uses zlib's streaming inflate for
+ * every backend, since whole-buffer decoders like libdeflate cannot stream.
+ *
+ * @param source Supplies compressed input chunks.
+ * @param sink Receives inflated output chunks.
+ * @param chunkSize Size of the output buffer.
+ * @return true if the stream ended cleanly, false on corrupt or truncated input or a failing callback.
+ */
+bool Decompressor::inflateStream(const InflateSource& source, const InflateSink& sink, size_t chunkSize) const {
+    z_stream stream = {};
+    if (inflateInit(&stream) != Z_OK) {
+        return false;
+    }
+
+    chunkSize = std::min<size_t>(std::max<size_t>(chunkSize, 4096), UINT_MAX);
+    std::vector<uint8_t> out(chunkSize);
+    bool ok = true;
+    int status = Z_OK;
+    while (status != Z_STREAM_END) {
+        if (stream.avail_in == 0) {
+            const uint8_t* data = nullptr;
+            size_t len = 0;
+            if (!source(data, len) || len == 0 || len > UINT_MAX) {
+                ok = false;
+                break;
+            }
+            stream.next_in = const_cast<Bytef*>(data);
+            stream.avail_in = static_cast<uInt>(len);
+        }
+
+        stream.next_out = out.data();
+        stream.avail_out = static_cast<uInt>(out.size());
+        status = inflate(&stream, Z_NO_FLUSH);
+        if (status != Z_OK && status != Z_STREAM_END) {
+            ok = false;
+            break;
+        }
+
+        size_t produced = out.size() - stream.avail_out;
+        if (produced > 0 && !sink(out.data(), produced)) {
+            ok = false;
+            break;
+        }
+    }
+
+    inflateEnd(&stream);
+    return ok;
+}
+
+namespace {
+
+// Stock zlib, always available
+class ZlibDecompressor : public Decompressor {
+public:
+    const char* name() const override {
+        return "zlib";
+    }
+
+    bool inflateBuffer(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstLen) const override {
+        if (static_cast<uLong>(srcLen) != srcLen || static_cast<uLongf>(dstLen) != dstLen) {
+            return false;
+        }
+        uLongf outLen = static_cast<uLongf>(dstLen);
+        int status = uncompress(dst, &outLen, src, static_cast<uLong>(srcLen));
+        return status == Z_OK && outLen == dstLen;
+    }
+};
+
+#ifdef PYINST_WITH_LIBDEFLATE
+// libdeflate, which decodes a whole buffer at once when the output size is known
+class LibdeflateDecompressor : public Decompressor {
+public:
+    const char* name() const override {
+        return "libdeflate";
+    }
+
+    bool inflateBuffer(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstLen) const override {
+        // libdeflate decompressors are not thread-safe, so every thread keeps its own
+        struct ThreadDecompressor {
+            libdeflate_decompressor* handle = libdeflate_alloc_decompressor();
+            ~ThreadDecompressor() {
+                libdeflate_free_decompressor(handle);
+            }
+        };
+        static thread_local ThreadDecompressor decompressor;
+        if (decompressor.handle == nullptr) {
+            return false;
+        }
+        size_t outLen = 0;
+        libdeflate_result result = libdeflate_zlib_decompress(decompressor.handle, src, srcLen, dst, dstLen, &outLen);
+        return result == LIBDEFLATE_SUCCESS && outLen == dstLen;
+    }
+};
+#endif
+
+} // namespace
+
+/**
+ * @brief Reports whether a backend was compiled into this build.
+ *
+ * @param backend The backend to check.
+ * @return true if createDecompressor() can provide it.
+ */
+bool isInflateBackendAvailable(InflateBackend backend) {
+    switch (backend) {
+    case InflateBackend::Auto:
+    case InflateBackend::Zlib:
+        return true;
+    case InflateBackend::Libdeflate:
+#ifdef PYINST_WITH_LIBDEFLATE
+        return true;
+#else
+        return false;
+#endif
+    }
+    return false;
+}
+
+/**
+ * @brief Creates the decompressor for a backend.
+ *
+ * `Auto` picks libdeflate when compiled in, zlib otherwise.
+ *
+ * @param backend The requested backend.
+ * @return The decompressor, or nullptr if the backend is not compiled in.
+ */
+std::unique_ptr<Decompressor> createDecompressor(InflateBackend backend) {
+    if (backend == InflateBackend::Auto) {
+#ifdef PYINST_WITH_LIBDEFLATE
+        backend = InflateBackend::Libdeflate;
+#else
+        backend = InflateBackend::Zlib;
+#endif
+    }
+
+    switch (backend) {
+    case InflateBackend::Zlib:
+        return std::make_unique<ZlibDecompressor>();
+#ifdef PYINST_WITH_LIBDEFLATE
+    case InflateBackend::Libdeflate:
+        return std::make_unique<LibdeflateDecompressor>();
+#endif
+    default:
+        return nullptr;
+    }
+}
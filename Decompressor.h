@@ -0,0 +1,42 @@
+#ifndef DECOMPRESSOR_H
+#define DECOMPRESSOR_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+#include <memory>
+
+// The optional libdeflate backend is compiled in with /DPYINST_WITH_LIBDEFLATE
+
+// Inflate implementation used for compressed entries
+enum class InflateBackend {
+    Auto,                          // Fastest backend compiled in
+    Zlib,                          // Stock zlib
+    Libdeflate                     // libdeflate whole-buffer decoder
+};
+
+// Provides the next chunk of compressed input; `len` is 0 at the end of the input
+using InflateSource = std::function<bool(const uint8_t*& data, size_t& len)>;
+
+// Receives each chunk of inflated output
+using InflateSink = std::function<bool(const uint8_t* data, size_t len)>;
+
+// Interface for inflating zlib streams; implementations are safe to share between threads
+class Decompressor {
+public:
+    virtual ~Decompressor() = default;
+
+    // Name of the backend, for logging
+    virtual const char* name() const = 0;
+
+    // Inflates a complete zlib stream whose uncompressed size is known up front
+    virtual bool inflateBuffer(const uint8_t* src, size_t srcLen, uint8_t* dst, size_t dstLen) const = 0;
+
+    // Inflates a zlib stream chunk by chunk with a fixed-size output buffer
+    virtual bool inflateStream(const InflateSource& source, const InflateSink& sink, size_t chunkSize) const;
+};
+
+bool isInflateBackendAvailable(InflateBackend backend);
+std::unique_ptr<Decompressor> createDecompressor(InflateBackend backend);
+
+#endif // DECOMPRESSOR_H
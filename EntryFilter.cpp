@@ -0,0 +1,134 @@
+#include "EntryFilter.h"
+
+/**
+ * @brief Matches a character against a bracket expression such as `[a-z]` or `[!0-9]`.
+ *
+ * @param pattern The pattern, positioned at the opening bracket.
+ * @param c The character to test.
+ * @param length Receives the length of the bracket expression, or 0 if it is not terminated.
+ * @return true if the character is accepted by the expression.
+ */
+static bool matchBracket(std::string_view pattern, char c, size_t& length) {
+    size_t i = 1;
+    bool negate = i < pattern.size() && (pattern[i] == '!' || pattern[i] == '^');
+    if (negate) {
+        ++i;
+    }
+    bool matched = false;
+    bool first = true;
+    while (i < pattern.size() && (pattern[i] != ']' || first)) {
+        first = false;
+        if (i + 2 < pattern.size() && pattern[i + 1] == '-' && pattern[i + 2] != ']') {
+            if (pattern[i] <= c && c <= pattern[i + 2]) {
+                matched = true;
+            }
+            i += 3;
+        }
+        else {
+            if (pattern[i] == c) {
+                matched = true;
+            }
+            ++i;
+        }
+    }
+    if (i >= pattern.size()) {
+        length = 0;
+        return false;
+    }
+    length = i + 1;
+    return matched != negate;
+}
+
+/**
+ * @brief Matches a name against a shell-style glob.
+ *
+ * Supports `*` (any run of characters, including path separators), `?` (any
+ * single character) and bracket expressions. An unterminated `[` matches
+ * itself literally. Mismatches backtrack only to the most recent `*`, so
+ * matching never recurses.
+ *
+ * @param pattern The glob.
+ * @param text The name to test.
+ * @return true if the whole name matches the glob.
+ */
+bool globMatch(std::string_view pattern, std::string_view text) {
+    size_t p = 0, t = 0;
+    size_t starPattern = std::string_view::npos, starText = 0;
+    while (t < text.size()) {
+        if (p < pattern.size()) {
+            char pc = pattern[p];
+            if (pc == '*') {
+                starPattern = p++;
+                starText = t;
+                continue;
+            }
+            if (pc == '?') {
+                ++p;
+                ++t;
+                continue;
+            }
+            if (pc == '[') {
+                size_t length;
+                bool matched = matchBracket(pattern.substr(p), text[t], length);
+                if (length == 0 && text[t] == '[') {
+                    ++p;
+                    ++t;
+                    continue;
+                }
+                if (length != 0 && matched) {
+                    p += length;
+                    ++t;
+                    continue;
+                }
+            }
+            else if (pc == text[t]) {
+                ++p;
+                ++t;
+                continue;
+            }
+        }
+        if (starPattern == std::string_view::npos) {
+            return false;
+        }
+        p = starPattern + 1;
+        t = ++starText;
+    }
+    while (p < pattern.size() && pattern[p] == '*') {
+        ++p;
+    }
+    return p == pattern.size();
+}
+
+/**
+ * @brief Decides whether an entry should be processed.
+ *
+ * Only TOC metadata is consulted: the type code and uncompressed size are
+ * checked first, then the exclude and include globs against the name.
+ *
+ * @param entry The TOC entry to test.
+ * @return true if the entry passes every configured criterion.
+ */
+bool EntryFilter::matches(const TocTable::Entry& entry) const {
+    if (!typeCodes.empty() && typeCodes.find(entry.getType()) == std::string::npos) {
+        return false;
+    }
+    uint64_t size = entry.getUncompressedDataSize();
+    if (size < minSize || size > maxSize) {
+        return false;
+    }
+    std::string_view name = entry.getName();
+    for (const auto& glob : excludeGlobs) {
+        if (globMatch(glob, name)) {
+            return false;
+        }
+    }
+    if (includeGlobs.empty()) {
+        return true;
+    }
+    for (const auto& glob : includeGlobs) {
+        if (globMatch(glob, name)) {
+            return true;
+        }
+    }
+    return false;
+}
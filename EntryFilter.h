@@ -0,0 +1,24 @@
+#ifndef ENTRYFILTER_H
+#define ENTRYFILTER_H
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "TocTable.h"
+
+// Selects TOC entries by name, type code and size before any payload is read
+struct EntryFilter {
+    std::vector<std::string> includeGlobs; // Name must match one of these, if any are given
+    std::vector<std::string> excludeGlobs; // Name must match none of these
+    std::string typeCodes;         // Allowed typeCmprsData values, empty for all
+    uint64_t minSize = 0;          // Smallest uncompressed size to accept
+    uint64_t maxSize = std::numeric_limits<uint64_t>::max(); // Largest uncompressed size to accept
+
+    bool matches(const TocTable::Entry& entry) const;
+};
+
+bool globMatch(std::string_view pattern, std::string_view text);
+
+#endif // ENTRYFILTER_H
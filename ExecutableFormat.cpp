@@ -0,0 +1,380 @@
+#include "ExecutableFormat.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+uint32_t readLE32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+uint32_t readBE32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+        (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+// Header tables larger than this are treated as malformed
+const size_t MAX_HEADER_TABLE_SIZE = 16 * 1024 * 1024;
+
+// Integer reader for the byte order of an ELF or Mach-O file
+struct FieldReader {
+    bool bigEndian;
+
+    uint64_t read(const uint8_t* p, size_t width) const {
+        uint64_t value = 0;
+        for (size_t i = 0; i < width; ++i) {
+            value |= static_cast<uint64_t>(p[bigEndian ? width - 1 - i : i]) << (8 * i);
+        }
+        return value;
+    }
+
+    uint16_t u16(const uint8_t* p) const {
+        return static_cast<uint16_t>(read(p, 2));
+    }
+
+    uint32_t u32(const uint8_t* p) const {
+        return static_cast<uint32_t>(read(p, 4));
+    }
+
+    uint64_t u64(const uint8_t* p) const {
+        return read(p, 8);
+    }
+};
+
+// Whether [offset, offset + len) lies inside the file, without overflowing the sum
+bool fitsInFile(uint64_t offset, uint64_t len, uint64_t fileSize) {
+    return offset <= fileSize && len <= fileSize - offset;
+}
+
+/**
+ * @brief Reads a header table of the inspected file into a buffer, bounded in size.
+ */
+bool readTable(const FileReader& read, uint64_t fileSize, uint64_t offset, uint64_t len, std::vector<uint8_t>& table) {
+    if (len > MAX_HEADER_TABLE_SIZE || !fitsInFile(offset, len, fileSize)) {
+        return false;
+    }
+    table.resize(static_cast<size_t>(len));
+    return len == 0 || read(offset, table.data(), table.size());
+}
+
+/**
+ * @brief PE: the archive is appended after the last section's raw data.
+ *
+ * The overlay starts where the section data and an optional COFF symbol
+ * table end; an Authenticode signature may follow the archive, so the region
+ * runs to the end of the file.
+ */
+bool locatePe(uint64_t fileSize, const FileReader& read, uint64_t& start) {
+    uint8_t dos[0x40];
+    uint8_t coff[24];
+    if (!read(0, dos, sizeof(dos))) {
+        return false;
+    }
+    uint32_t peOffset = readLE32(dos + 0x3C);
+    if (!read(peOffset, coff, sizeof(coff)) || std::memcmp(coff, "PE\0\0", 4) != 0) {
+        return false;
+    }
+    uint16_t sectionCount = static_cast<uint16_t>(coff[6] | (coff[7] << 8));
+    uint16_t optionalSize = static_cast<uint16_t>(coff[20] | (coff[21] << 8));
+    uint64_t tableOffset = static_cast<uint64_t>(peOffset) + sizeof(coff) + optionalSize;
+    std::vector<uint8_t> sections;
+    if (!readTable(read, fileSize, tableOffset, sectionCount * 40ull, sections)) {
+        return false;
+    }
+
+    uint64_t end = tableOffset + sections.size();
+    for (size_t i = 0; i < sectionCount; ++i) {
+        const uint8_t* section = sections.data() + 40 * i;
+        uint32_t rawSize = readLE32(section + 16);
+        uint32_t rawPointer = readLE32(section + 20);
+        if (rawSize > 0) {
+            if (!fitsInFile(rawPointer, rawSize, fileSize)) {
+                return false;
+            }
+            end = std::max<uint64_t>(end, static_cast<uint64_t>(rawPointer) + rawSize);
+        }
+    }
+    uint32_t symbolTable = readLE32(coff + 12);
+    uint32_t symbolCount = readLE32(coff + 16);
+    if (symbolTable != 0) {
+        // The string table follows the symbols and starts with its own size
+        uint64_t strings = static_cast<uint64_t>(symbolTable) + symbolCount * 18ull;
+        uint8_t stringSize[4];
+        if (!fitsInFile(strings, 0, fileSize)) {
+            return false;
+        }
+        end = std::max(end, strings);
+        if (read(strings, stringSize, sizeof(stringSize)) && fitsInFile(strings, readLE32(stringSize), fileSize)) {
+            end = std::max(end, strings + readLE32(stringSize));
+        }
+    }
+    if (end > fileSize) {
+        return false;
+    }
+    start = end;
+    return true;
+}
+
+/**
+ * @brief ELF: the archive is the `.pydata` section, or else appended after everything the headers describe.
+ *
+ * Recent PyInstaller versions embed the archive as a `.pydata` section so
+ * that strip and similar tools keep it; older ones append it to the file.
+ */
+bool locateElf(uint64_t fileSize, const FileReader& read, uint64_t& start, uint64_t& end) {
+    uint8_t header[64];
+    if (!read(0, header, sizeof(header)) || (header[4] != 1 && header[4] != 2) || (header[5] != 1 && header[5] != 2)) {
+        return false;
+    }
+    bool is64 = header[4] == 2;
+    FieldReader field{ header[5] == 2 };
+    uint64_t phOffset = is64 ? field.u64(header + 0x20) : field.u32(header + 0x1C);
+    uint64_t shOffset = is64 ? field.u64(header + 0x28) : field.u32(header + 0x20);
+    uint16_t phEntrySize = field.u16(header + (is64 ? 0x36 : 0x2A));
+    uint16_t phCount = field.u16(header + (is64 ? 0x38 : 0x2C));
+    uint16_t shEntrySize = field.u16(header + (is64 ? 0x3A : 0x2E));
+    uint16_t shCount = field.u16(header + (is64 ? 0x3C : 0x30));
+    uint16_t shNames = field.u16(header + (is64 ? 0x3E : 0x32));
+    size_t minPh = is64 ? 0x38 : 0x20;
+    size_t minSh = is64 ? 0x40 : 0x28;
+
+    uint64_t dataEnd = is64 ? 64 : 52;
+    std::vector<uint8_t> programs;
+    if (phCount > 0) {
+        if (phEntrySize < minPh || !readTable(read, fileSize, phOffset, static_cast<uint64_t>(phCount) * phEntrySize, programs)) {
+            return false;
+        }
+        dataEnd = std::max(dataEnd, phOffset + programs.size());
+        for (size_t i = 0; i < phCount; ++i) {
+            const uint8_t* program = programs.data() + i * phEntrySize;
+            uint64_t offset = is64 ? field.u64(program + 0x08) : field.u32(program + 0x04);
+            uint64_t size = is64 ? field.u64(program + 0x20) : field.u32(program + 0x10);
+            if (!fitsInFile(offset, size, fileSize)) {
+                return false;
+            }
+            dataEnd = std::max(dataEnd, offset + size);
+        }
+    }
+
+    std::vector<uint8_t> sections;
+    if (shCount > 0) {
+        if (shEntrySize < minSh || !readTable(read, fileSize, shOffset, static_cast<uint64_t>(shCount) * shEntrySize, sections)) {
+            return false;
+        }
+        dataEnd = std::max(dataEnd, shOffset + sections.size());
+        auto sectionOffset = [&](const uint8_t* section) {
+            return is64 ? field.u64(section + 0x18) : field.u32(section + 0x10);
+        };
+        auto sectionSize = [&](const uint8_t* section) {
+            return is64 ? field.u64(section + 0x20) : field.u32(section + 0x14);
+        };
+
+        std::vector<uint8_t> names;
+        if (shNames < shCount) {
+            const uint8_t* nameSection = sections.data() + static_cast<size_t>(shNames) * shEntrySize;
+            if (!readTable(read, fileSize, sectionOffset(nameSection), sectionSize(nameSection), names)) {
+                names.clear();
+            }
+        }
+        const uint32_t SHT_NOBITS = 8;
+        for (size_t i = 0; i < shCount; ++i) {
+            const uint8_t* section = sections.data() + i * shEntrySize;
+            uint32_t nameIndex = field.u32(section);
+            if (nameIndex < names.size() && names.size() - nameIndex >= sizeof(".pydata") &&
+                std::memcmp(names.data() + nameIndex, ".pydata", sizeof(".pydata")) == 0) {
+                if (!fitsInFile(sectionOffset(section), sectionSize(section), fileSize)) {
+                    return false;
+                }
+                start = sectionOffset(section);
+                end = start + sectionSize(section);
+                return true;
+            }
+            if (field.u32(section + 4) != SHT_NOBITS) {
+                if (!fitsInFile(sectionOffset(section), sectionSize(section), fileSize)) {
+                    return false;
+                }
+                dataEnd = std::max(dataEnd, sectionOffset(section) + sectionSize(section));
+            }
+        }
+    }
+    if (dataEnd > fileSize) {
+        return false;
+    }
+    start = dataEnd;
+    return true;
+}
+
+/**
+ * @brief Mach-O: the archive sits at the end of __LINKEDIT, or after the last segment.
+ *
+ * PyInstaller extends the __LINKEDIT segment over the appended archive so
+ * that the binary can be code-signed, and the signature then follows the
+ * archive. The region starts at __LINKEDIT, or at the end of the last segment
+ * for older builds that append the archive without adjusting the headers.
+ *
+ * @param base Offset of the Mach-O image in the file, non-zero for slices of universal binaries.
+ */
+bool locateMachO(uint64_t fileSize, const FileReader& read, uint64_t base, uint64_t& start) {
+    uint8_t header[32];
+    if (!read(base, header, sizeof(header))) {
+        return false;
+    }
+    uint32_t magic = readBE32(header);
+    bool is64 = magic == 0xFEEDFACF || magic == 0xCFFAEDFE;
+    FieldReader field{ magic == 0xFEEDFACE || magic == 0xFEEDFACF };
+    if (!is64 && magic != 0xFEEDFACE && magic != 0xCEFAEDFE) {
+        return false;
+    }
+    uint32_t commandCount = field.u32(header + 16);
+    uint32_t commandsSize = field.u32(header + 20);
+    std::vector<uint8_t> commands;
+    if (!readTable(read, fileSize, base + (is64 ? 32 : 28), commandsSize, commands)) {
+        return false;
+    }
+
+    const uint32_t LC_SEGMENT = 0x1;
+    const uint32_t LC_SEGMENT_64 = 0x19;
+    uint64_t segmentsEnd = 0;
+    uint64_t linkedit = 0;
+    bool hasLinkedit = false;
+    size_t pos = 0;
+    for (uint32_t i = 0; i < commandCount && pos + 8 <= commands.size(); ++i) {
+        const uint8_t* command = commands.data() + pos;
+        uint32_t type = field.u32(command);
+        uint32_t size = field.u32(command + 4);
+        if (size < 8 || size > commands.size() - pos) {
+            return false;
+        }
+        if ((type == LC_SEGMENT && size >= 56) || (type == LC_SEGMENT_64 && size >= 72)) {
+            uint64_t fileOffset = type == LC_SEGMENT_64 ? field.u64(command + 40) : field.u32(command + 32);
+            uint64_t fileBytes = type == LC_SEGMENT_64 ? field.u64(command + 48) : field.u32(command + 36);
+            if (!fitsInFile(fileOffset, fileBytes, fileSize - base)) {
+                return false;
+            }
+            segmentsEnd = std::max(segmentsEnd, fileOffset + fileBytes);
+            if (std::strncmp(reinterpret_cast<const char*>(command + 8), "__LINKEDIT", 16) == 0) {
+                linkedit = fileOffset;
+                hasLinkedit = true;
+            }
+        }
+        pos += size;
+    }
+    uint64_t offset = hasLinkedit ? linkedit : segmentsEnd;
+    if (!fitsInFile(base, offset, fileSize)) {
+        return false;
+    }
+    start = base + offset;
+    return true;
+}
+
+/**
+ * @brief Universal Mach-O: searches from the last slice's __LINKEDIT, which also covers data appended to the whole file.
+ */
+bool locateUniversal(uint64_t fileSize, const FileReader& read, uint64_t& start) {
+    uint8_t header[8];
+    if (!read(0, header, sizeof(header))) {
+        return false;
+    }
+    uint32_t count = readBE32(header + 4);
+    std::vector<uint8_t> archs;
+    if (!readTable(read, fileSize, sizeof(header), count * 20ull, archs)) {
+        return false;
+    }
+    uint64_t lastOffset = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        lastOffset = std::max<uint64_t>(lastOffset, readBE32(archs.data() + 20 * i + 8));
+    }
+    return count > 0 && locateMachO(fileSize, read, lastOffset, start);
+}
+
+} // namespace
+
+/**
+ * @brief Recognizes the executable format from the first bytes of a file.
+ *
+ * A PE file needs the `MZ` stub and, when `e_lfanew` points inside the probe,
+ * the `PE\0\0` signature there. Universal Mach-O binaries share their magic
+ * with Java class files, which are told apart by the architecture count.
+ *
+ * @param head Start of the file.
+ * @param len Number of bytes available, ideally EXECUTABLE_HEADER_PROBE_SIZE.
+ * @return The format, or ExecutableFormat::Unknown.
+ */
+ExecutableFormat detectExecutableFormat(const uint8_t* head, size_t len) {
+    if (len < 4) {
+        return ExecutableFormat::Unknown;
+    }
+    if (head[0] == 'M' && head[1] == 'Z') {
+        if (len >= 0x40) {
+            uint32_t peOffset = readLE32(head + 0x3C);
+            if (peOffset <= len - 4 &&
+                !(head[peOffset] == 'P' && head[peOffset + 1] == 'E' && head[peOffset + 2] == 0 && head[peOffset + 3] == 0)) {
+                return ExecutableFormat::Unknown;
+            }
+        }
+        return ExecutableFormat::Pe;
+    }
+    if (head[0] == 0x7F && head[1] == 'E' && head[2] == 'L' && head[3] == 'F') {
+        return ExecutableFormat::Elf;
+    }
+    uint32_t magic = readBE32(head);
+    if (magic == 0xFEEDFACE || magic == 0xFEEDFACF || magic == 0xCEFAEDFE || magic == 0xCFFAEDFE) {
+        return ExecutableFormat::MachO;
+    }
+    if (magic == 0xCAFEBABE && len >= 8 && readBE32(head + 4) > 0 && readBE32(head + 4) < 32) {
+        return ExecutableFormat::MachO;
+    }
+    return ExecutableFormat::Unknown;
+}
+
+/**
+ * @brief Computes the byte range of an executable that can hold the PyInstaller archive.
+ *
+ * Only headers and section or segment tables are read, typically a few
+ * kilobytes, so the cookie search can skip the code and data of large
+ * binaries. The range always covers the archive's cookie for executables
+ * built by PyInstaller; callers fall back to scanning the whole file when
+ * this returns false.
+ *
+ * @param format Format reported by detectExecutableFormat().
+ * @param fileSize Size of the file.
+ * @param read Random access to the file.
+ * @param start Receives the first byte of the range.
+ * @param end Receives the end of the range.
+ * @return true if the headers were parsed, false if they are malformed or the format is unknown.
+ */
+bool locateArchiveRegion(ExecutableFormat format, uint64_t fileSize, const FileReader& read, uint64_t& start, uint64_t& end) {
+    uint8_t magic[4];
+    end = fileSize;
+    switch (format) {
+    case ExecutableFormat::Pe:
+        return locatePe(fileSize, read, start);
+    case ExecutableFormat::Elf:
+        return locateElf(fileSize, read, start, end);
+    case ExecutableFormat::MachO:
+        if (!read(0, magic, sizeof(magic))) {
+            return false;
+        }
+        return readBE32(magic) == 0xCAFEBABE ? locateUniversal(fileSize, read, start) : locateMachO(fileSize, read, 0, start);
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Returns a short printable name of a format.
+ */
+const char* executableFormatName(ExecutableFormat format) {
+    switch (format) {
+    case ExecutableFormat::Pe:
+        return "PE";
+    case ExecutableFormat::Elf:
+        return "ELF";
+    case ExecutableFormat::MachO:
+        return "Mach-O";
+    default:
+        return "unknown";
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef EXECUTABLEFORMAT_H
+#define EXECUTABLEFORMAT_H
+
+#include <cstdint>
+#include <cstddef>
+#include <functional>
+
+// Container format of an executable, as far as PyInstaller bootloaders are concerned
+enum class ExecutableFormat {
+    Unknown,                       // Not an executable, or a bare CArchive package
+    Pe,                            // Windows Portable Executable
+    Elf,                           // Linux and other Unix ELF binaries
+    MachO                          // macOS Mach-O, thin or universal
+};
+
+// Bytes from the start of a file needed by detectExecutableFormat()
+const size_t EXECUTABLE_HEADER_PROBE_SIZE = 512;
+
+// Recognizes the executable format from the first bytes of a file
+ExecutableFormat detectExecutableFormat(const uint8_t* head, size_t len);
+
+// Printable name of a format
+const char* executableFormatName(ExecutableFormat format);
+
+// Reads `len` bytes at `offset` of the file being inspected, false if out of range
+using FileReader = std::function<bool(uint64_t offset, void* dst, size_t len)>;
+
+// Computes the byte range [start, end) of an executable that can hold the PyInstaller archive
+bool locateArchiveRegion(ExecutableFormat format, uint64_t fileSize, const FileReader& read, uint64_t& start, uint64_t& end);
+
+#endif // EXECUTABLEFORMAT_H
@@ -0,0 +1,199 @@
+#include "ExtractManifest.h"
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+const char* const MANIFEST_HEADER = "# pyinstxtractor manifest 2";
+const std::string SOURCE_PREFIX = "# source\t";
+
+} // namespace
+
+/**
+ * @brief Sets the fingerprint of the archive file, written to the manifest and the journal.
+ *
+ * Must be called before load() and openJournal().
+ *
+ * @param fingerprint Size and modification time of the archive file, or empty for archives in memory.
+ */
+void ExtractManifest::setSource(const std::string& fingerprint) {
+    source = fingerprint;
+}
+
+/**
+ * @brief Tells whether the records read were written for the same archive file.
+ *
+ * Then the TOC fields of an entry identify its record, and its raw bytes do
+ * not need to be hashed to know whether it changed.
+ */
+bool ExtractManifest::isSameSource() const {
+    return !source.empty() && sameSource;
+}
+
+/**
+ * @brief Reads the manifest left by the previous run.
+ *
+ * A manifest written with different settings describes outputs this run
+ * would not produce, so it is ignored.
+ *
+ * @param file Path of the manifest.
+ * @param settings Summary of the options that affect the outputs.
+ * @return true if a matching manifest was loaded, false if there is none.
+ */
+bool ExtractManifest::load(const std::filesystem::path& file, const std::string& settings) {
+    previous.clear();
+    sameSource = true;
+    return readEntries(file, settings);
+}
+
+/**
+ * @brief Resumes or starts the journal of completed outputs.
+ *
+ * Every record() is appended and flushed to the journal right away, so after
+ * an interruption it lists what was finished. An existing journal with the
+ * same settings is read first and its records take precedence over the
+ * loaded manifest; the run then appends to it. Records of an interrupted
+ * last line simply fail to match and the output is extracted again.
+ *
+ * @param file Path of the journal.
+ * @param settings Summary of the options that affect the outputs.
+ * @return true if an interrupted run was found and is resumed, false if the journal starts empty.
+ */
+bool ExtractManifest::openJournal(const std::filesystem::path& file, const std::string& settings) {
+    closeJournal(false);
+    bool resumed = readEntries(file, settings);
+    journalPath = file;
+    journal.open(file, std::ios::binary | (resumed ? std::ios::app : std::ios::trunc));
+    if (!resumed) {
+        journal << MANIFEST_HEADER << '\t' << settings << '\n';
+        if (!source.empty()) {
+            journal << SOURCE_PREFIX << source << '\n';
+        }
+        journal << std::flush;
+    }
+    return resumed;
+}
+
+/**
+ * @brief Stops journaling.
+ *
+ * @param remove Whether to delete the journal, once the run has completed.
+ */
+void ExtractManifest::closeJournal(bool remove) {
+    if (!journal.is_open()) {
+        return;
+    }
+    journal.close();
+    if (remove) {
+        std::error_code ec;
+        std::filesystem::remove(journalPath, ec);
+    }
+}
+
+/**
+ * @brief Adds the records of a manifest or journal file to the previous ones.
+ *
+ * A file without the fingerprint of the current archive file clears
+ * isSameSource(), as its records may describe another build.
+ *
+ * @return true if the file exists and was written with the same settings.
+ */
+bool ExtractManifest::readEntries(const std::filesystem::path& file, const std::string& settings) {
+    std::ifstream in(file, std::ios::binary);
+    std::string line;
+    if (!std::getline(in, line) || line != std::string(MANIFEST_HEADER) + '\t' + settings) {
+        return false;
+    }
+    bool sourceMatches = false;
+    while (std::getline(in, line)) {
+        if (line.compare(0, SOURCE_PREFIX.size(), SOURCE_PREFIX) == 0) {
+            sourceMatches = !source.empty() && line.compare(SOURCE_PREFIX.size(), std::string::npos, source) == 0;
+            continue;
+        }
+        std::istringstream fields(line);
+        ManifestEntry entry;
+        if (std::getline(fields, entry.hash, '\t') && fields >> entry.compressedSize >> entry.position >> entry.outputSize >> entry.children &&
+            fields.get() == '\t' && std::getline(fields, entry.name) && !entry.name.empty()) {
+            std::string name = entry.name;
+            previous[name] = std::move(entry);
+        }
+    }
+    sameSource = sameSource && sourceMatches;
+    return true;
+}
+
+/**
+ * @brief Looks up the previous record of an output.
+ *
+ * @param name Path of the output relative to the output directory.
+ * @return The record, or nullptr if the previous run did not write it.
+ */
+const ManifestEntry* ExtractManifest::findPrevious(const std::string& name) const {
+    auto it = previous.find(name);
+    return it != previous.end() ? &it->second : nullptr;
+}
+
+/**
+ * @brief Adds an output confirmed by this run and appends it to the journal. Thread-safe.
+ */
+void ExtractManifest::record(ManifestEntry entry) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (journal.is_open()) {
+        journal << entry.hash << '\t' << entry.compressedSize << '\t' << entry.position << '\t'
+            << entry.outputSize << '\t' << entry.children << '\t' << entry.name << '\n' << std::flush;
+    }
+    current.push_back(std::move(entry));
+}
+
+/**
+ * @brief Returns the previous records below a directory, such as the contents of an expanded archive.
+ *
+ * The records are sorted by name, so only the matching range is visited.
+ *
+ * @param prefix Directory prefix of the records, ending in '/'.
+ */
+std::vector<const ManifestEntry*> ExtractManifest::findPreviousBelow(const std::string& prefix) const {
+    std::vector<const ManifestEntry*> entries;
+    for (auto it = previous.lower_bound(prefix); it != previous.end() && it->first.compare(0, prefix.size(), prefix) == 0; ++it) {
+        entries.push_back(&it->second);
+    }
+    return entries;
+}
+
+/**
+ * @brief Writes the outputs of this run, sorted by name.
+ *
+ * The manifest is written to a temp file and renamed over the old one, so an
+ * interrupted save leaves the previous manifest intact.
+ *
+ * @param file Path of the manifest.
+ * @param settings Summary of the options that affect the outputs.
+ * @return true if the manifest was written, false otherwise.
+ */
+bool ExtractManifest::save(const std::filesystem::path& file, const std::string& settings) {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::sort(current.begin(), current.end(), [](const ManifestEntry& a, const ManifestEntry& b) {
+        return a.name < b.name;
+    });
+    std::filesystem::path temp = file;
+    temp += ".tmp";
+    {
+        std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+        out << MANIFEST_HEADER << '\t' << settings << '\n';
+        if (!source.empty()) {
+            out << SOURCE_PREFIX << source << '\n';
+        }
+        for (const ManifestEntry& entry : current) {
+            out << entry.hash << '\t' << entry.compressedSize << '\t' << entry.position << '\t'
+                << entry.outputSize << '\t' << entry.children << '\t' << entry.name << '\n';
+        }
+        out.close();
+        if (out.fail()) {
+            return false;
+        }
+    }
+    std::error_code ec;
+    std::filesystem::rename(temp, file, ec);
+    return !ec;
+}
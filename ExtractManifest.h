@@ -0,0 +1,55 @@
+#ifndef EXTRACTMANIFEST_H
+#define EXTRACTMANIFEST_H
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Name of the manifest kept in the output directory of incremental runs
+const char* const EXTRACT_MANIFEST_NAME = "extract-manifest.tsv";
+
+// Name of the journal of completed outputs kept in the output directory of resumable runs
+const char* const EXTRACT_JOURNAL_NAME = "extract-journal.tsv";
+
+// Record of one extracted output and the archive bytes it came from
+struct ManifestEntry {
+    std::string name;              // Path relative to the output directory, '/'-separated
+    uint64_t compressedSize;       // Size of the entry or module in its archive
+    uint64_t position;             // Offset of the entry or module in its archive
+    uint64_t outputSize;           // Size of the written file
+    std::string hash;              // SHA-256 of the raw entry bytes, lowercase hex
+    uint64_t children = 0;         // Records below `<name>_extracted/` written with it, for archive entries
+};
+
+// Outputs of the previous extraction into a directory and of the current one
+class ExtractManifest {
+public:
+    // Member functions
+    void setSource(const std::string& fingerprint);
+    bool isSameSource() const;
+    bool load(const std::filesystem::path& file, const std::string& settings);
+    bool openJournal(const std::filesystem::path& file, const std::string& settings);
+    void closeJournal(bool remove);
+    const ManifestEntry* findPrevious(const std::string& name) const;
+    void record(ManifestEntry entry);
+    std::vector<const ManifestEntry*> findPreviousBelow(const std::string& prefix) const;
+    bool save(const std::filesystem::path& file, const std::string& settings);
+
+private:
+    bool readEntries(const std::filesystem::path& file, const std::string& settings);
+
+    std::string source;            // Fingerprint of the archive file being extracted, empty if unknown
+    bool sameSource = true;        // Whether every manifest and journal read was written for the same fingerprint
+    std::map<std::string, ManifestEntry> previous; // Loaded manifest by name, read-only during a run; sorted for prefix lookups
+    std::mutex mutex;              // Guards current
+    std::vector<ManifestEntry> current; // Outputs confirmed by this run
+    std::ofstream journal;         // Append-only log of current, if resumable
+    std::filesystem::path journalPath; // Path of journal
+};
+
+#endif // EXTRACTMANIFEST_H
@@ -0,0 +1,79 @@
+#include "Logger.h"
+#include <atomic>
+#include <iostream>
+#include <mutex>
+
+static std::atomic<int> runtimeLogLevel(static_cast<int>(COMPILED_LOG_LEVEL));
+static std::mutex logMutex;
+static thread_local bool hasThreadLogLevel = false;
+static thread_local LogLevel threadLogLevel = LogLevel::Off;
+
+/**
+ * @brief Sets the most verbose level that is written at runtime.
+ *
+ * Levels that were compiled out by PYINST_LOG_LEVEL cannot be re-enabled here.
+ *
+ * @param level The new runtime threshold.
+ */
+void setLogLevel(LogLevel level) {
+    runtimeLogLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+/**
+ * @brief Returns the runtime log threshold of the calling thread.
+ */
+LogLevel getLogLevel() {
+    if (hasThreadLogLevel) {
+        return threadLogLevel;
+    }
+    return static_cast<LogLevel>(runtimeLogLevel.load(std::memory_order_relaxed));
+}
+
+/**
+ * @brief Overrides the runtime threshold for the calling thread.
+ *
+ * Lets worker threads silence per-file messages, for example while scanning
+ * many files, without changing what other threads log.
+ *
+ * @param level The threshold for this thread.
+ */
+void setThreadLogLevel(LogLevel level) {
+    threadLogLevel = level;
+    hasThreadLogLevel = true;
+}
+
+/**
+ * @brief Makes the calling thread follow the global threshold again.
+ */
+void resetThreadLogLevel() {
+    hasThreadLogLevel = false;
+}
+
+/**
+ * @brief Writes one log line with its level prefix.
+ *
+ * Info and debug lines go to stdout with a plain newline so that they stay in
+ * the stream buffer. Errors flush stdout first to keep the relative order of
+ * both streams and are then written to stderr. Lines from concurrent threads
+ * are never interleaved.
+ *
+ * @param level Severity of the line.
+ * @param line Message text without prefix or trailing newline.
+ */
+void writeLogLine(LogLevel level, const std::string& line) {
+    std::lock_guard<std::mutex> lock(logMutex);
+    switch (level) {
+    case LogLevel::Error:
+        std::cout.flush();
+        std::cerr << "[!] Error: " << line << '\n';
+        break;
+    case LogLevel::Info:
+        std::cout << "[+] " << line << '\n';
+        break;
+    case LogLevel::Debug:
+        std::cout << "[DEBUG] " << line << '\n';
+        break;
+    case LogLevel::Off:
+        break;
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <sstream>
+#include <string>
+
+// Severity of a log message, lower values are more important
+enum class LogLevel : int {
+    Off = -1,                     // Threshold only, suppresses every message
+    Error = 0,                    // Failures, written to stderr
+    Info = 1,                     // Progress and results
+    Debug = 2                     // Per-field parser tracing
+};
+
+// Most verbose level compiled into the binary; calls above it are removed entirely.
+// Override with /DPYINST_LOG_LEVEL=<0..2>.
+#ifndef PYINST_LOG_LEVEL
+#ifdef _DEBUG
+#define PYINST_LOG_LEVEL 2
+#else
+#define PYINST_LOG_LEVEL 1
+#endif
+#endif
+
+constexpr LogLevel COMPILED_LOG_LEVEL = static_cast<LogLevel>(PYINST_LOG_LEVEL);
+
+// Runtime threshold, only consulted for levels that are compiled in
+void setLogLevel(LogLevel level);
+LogLevel getLogLevel();
+
+// Threshold for the calling thread only, taking precedence over setLogLevel() until reset
+void setThreadLogLevel(LogLevel level);
+void resetThreadLogLevel();
+
+// Sets the calling thread's threshold and resets it when leaving the scope, even by an exception
+class ScopedThreadLogLevel {
+public:
+    explicit ScopedThreadLogLevel(LogLevel level) {
+        setThreadLogLevel(level);
+    }
+    ~ScopedThreadLogLevel() {
+        resetThreadLogLevel();
+    }
+
+    ScopedThreadLogLevel(const ScopedThreadLogLevel&) = delete;
+    ScopedThreadLogLevel& operator=(const ScopedThreadLogLevel&) = delete;
+};
+
+// Writes a fully formatted line to the log sink
+void writeLogLine(LogLevel level, const std::string& line);
+
+/**
+ * @brief Formats and writes a log line if `Level` is enabled.
+ *
+ * Levels above COMPILED_LOG_LEVEL compile to nothing, including the
+ * formatting of the arguments. Enabled lines are assembled in memory and
+ * handed to the sink in one write without flushing stdout.
+ */
+template <LogLevel Level, typename... Args>
+inline void logMessage(const Args&... args) {
+    if constexpr (Level <= COMPILED_LOG_LEVEL) {
+        if (static_cast<int>(Level) > static_cast<int>(getLogLevel())) {
+            return;
+        }
+        std::ostringstream line;
+        (line << ... << args);
+        writeLogLine(Level, line.str());
+    }
+}
+
+template <typename... Args>
+inline void logError(const Args&... args) {
+    logMessage<LogLevel::Error>(args...);
+}
+
+template <typename... Args>
+inline void logInfo(const Args&... args) {
+    logMessage<LogLevel::Info>(args...);
+}
+
+template <typename... Args>
+inline void logDebug(const Args&... args) {
+    logMessage<LogLevel::Debug>(args...);
+}
+
+#endif // LOGGER_H
@@ -0,0 +1,180 @@
+#include "MagicScanner.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define PYINST_SCANNER_X86 1
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define PYINST_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define PYINST_TARGET_AVX2
+#endif
+
+namespace {
+
+const uint8_t MAGIC_BYTES[MAGIC_SIZE] = { 'M', 'E', 'I', 014, 013, 012, 013, 016 };
+
+/**
+ * @brief Returns the index of the most significant set bit of a non-zero mask.
+ */
+inline unsigned highestBit(uint32_t mask) {
+#ifdef _MSC_VER
+    unsigned long index;
+    _BitScanReverse(&index, mask);
+    return static_cast<unsigned>(index);
+#else
+    return 31u - static_cast<unsigned>(__builtin_clz(mask));
+#endif
+}
+
+/**
+ * @brief Checks a candidate mask from the highest position downwards.
+ *
+ * Bit `k` of `mask` marks a position `base + k` whose first and last magic
+ * bytes already match; the remaining bytes are verified here.
+ */
+inline const uint8_t* verifyCandidates(const uint8_t* base, uint32_t mask) {
+    while (mask != 0) {
+        unsigned bit = highestBit(mask);
+        if (std::memcmp(base + bit, MAGIC_BYTES, MAGIC_SIZE) == 0) {
+            return base + bit;
+        }
+        mask &= ~(1u << bit);
+    }
+    return nullptr;
+}
+
+#ifdef PYINST_SCANNER_X86
+/**
+ * @brief SSE2 backward scan over 16 candidate positions per iteration.
+ *
+ * Each block compares the first and last magic bytes at 16 consecutive
+ * positions and only runs the full comparison where both match, so the
+ * inner loop touches every byte of the buffer roughly twice.
+ *
+ * @param data Start of the buffer.
+ * @param len Length of the buffer; must be at least MAGIC_SIZE.
+ * @return Pointer to the last occurrence of the magic, or nullptr.
+ */
+const uint8_t* findLastMagicSSE2(const uint8_t* data, size_t len) {
+    const __m128i first = _mm_set1_epi8(static_cast<char>(MAGIC_BYTES[0]));
+    const __m128i last = _mm_set1_epi8(static_cast<char>(MAGIC_BYTES[MAGIC_SIZE - 1]));
+    size_t i = len - MAGIC_SIZE + 1;  // Positions >= i have been checked
+
+    while (i >= 16) {
+        size_t p = i - 16;
+        __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + p));
+        __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + p + MAGIC_SIZE - 1));
+        __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(a, first), _mm_cmpeq_epi8(b, last));
+        uint32_t mask = static_cast<uint32_t>(_mm_movemask_epi8(eq));
+        if (mask != 0) {
+            const uint8_t* hit = verifyCandidates(data + p, mask);
+            if (hit != nullptr) {
+                return hit;
+            }
+        }
+        i = p;
+    }
+    return findLastMagicScalar(data, i + MAGIC_SIZE - 1);
+}
+
+/**
+ * @brief AVX2 variant of findLastMagicSSE2() working on 32 positions per iteration.
+ */
+PYINST_TARGET_AVX2
+const uint8_t* findLastMagicAVX2(const uint8_t* data, size_t len) {
+    const __m256i first = _mm256_set1_epi8(static_cast<char>(MAGIC_BYTES[0]));
+    const __m256i last = _mm256_set1_epi8(static_cast<char>(MAGIC_BYTES[MAGIC_SIZE - 1]));
+    size_t i = len - MAGIC_SIZE + 1;  // Positions >= i have been checked
+
+    while (i >= 32) {
+        size_t p = i - 32;
+        __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + p));
+        __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + p + MAGIC_SIZE - 1));
+        __m256i eq = _mm256_and_si256(_mm256_cmpeq_epi8(a, first), _mm256_cmpeq_epi8(b, last));
+        uint32_t mask = static_cast<uint32_t>(_mm256_movemask_epi8(eq));
+        if (mask != 0) {
+            const uint8_t* hit = verifyCandidates(data + p, mask);
+            if (hit != nullptr) {
+                return hit;
+            }
+        }
+        i = p;
+    }
+    return findLastMagicScalar(data, i + MAGIC_SIZE - 1);
+}
+
+/**
+ * @brief Detects at runtime whether the CPU and the OS support AVX2.
+ */
+bool cpuHasAVX2() {
+#ifdef _MSC_VER
+    int regs[4];
+    __cpuid(regs, 0);
+    if (regs[0] < 7) {
+        return false;
+    }
+    __cpuid(regs, 1);
+    bool osxsave = (regs[2] & (1 << 27)) != 0;
+    bool avx = (regs[2] & (1 << 28)) != 0;
+    if (!osxsave || !avx || (_xgetbv(0) & 0x6) != 0x6) {
+        return false;
+    }
+    __cpuidex(regs, 7, 0);
+    return (regs[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif // PYINST_SCANNER_X86
+
+} // namespace
+
+/**
+ * @brief Byte-by-byte backward search for the cookie magic.
+ *
+ * @param data Start of the buffer.
+ * @param len Length of the buffer.
+ * @return Pointer to the last occurrence of the magic, or nullptr.
+ */
+const uint8_t* findLastMagicScalar(const uint8_t* data, size_t len) {
+    if (len < MAGIC_SIZE) {
+        return nullptr;
+    }
+    for (size_t i = len - MAGIC_SIZE + 1; i-- > 0;) {
+        if (data[i] == MAGIC_BYTES[0] && std::memcmp(data + i, MAGIC_BYTES, MAGIC_SIZE) == 0) {
+            return data + i;
+        }
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Finds the last occurrence of the PyInstaller cookie magic in a buffer.
+ *
+ * Dispatches once to the widest vector implementation supported by the CPU
+ * (AVX2, then SSE2) and falls back to the scalar search elsewhere. The buffer
+ * is searched in place from its end towards its start, so the cookie of a
+ * regular archive is found after touching only the last few bytes.
+ *
+ * @param data Start of the buffer.
+ * @param len Length of the buffer.
+ * @return Pointer to the last occurrence of the magic, or nullptr if absent.
+ */
+const uint8_t* findLastMagic(const uint8_t* data, size_t len) {
+    if (len < MAGIC_SIZE) {
+        return nullptr;
+    }
+#ifdef PYINST_SCANNER_X86
+    static const bool useAVX2 = cpuHasAVX2();
+    return useAVX2 ? findLastMagicAVX2(data, len) : findLastMagicSSE2(data, len);
+#else
+    return findLastMagicScalar(data, len);
+#endif
+}
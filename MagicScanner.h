@@ -0,0 +1,16 @@
+#ifndef MAGICSCANNER_H
+#define MAGICSCANNER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Length of the PyInstaller cookie magic `MEI\014\013\012\013\016`
+const size_t MAGIC_SIZE = 8;
+
+// Finds the last occurrence of the cookie magic in a buffer, or nullptr
+const uint8_t* findLastMagic(const uint8_t* data, size_t len);
+
+// Portable reference implementation used for short buffers and non-x86 targets
+const uint8_t* findLastMagicScalar(const uint8_t* data, size_t len);
+
+#endif // MAGICSCANNER_H
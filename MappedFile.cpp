@@ -0,0 +1,182 @@
+#include "MappedFile.h"
+#include <cstring>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile() :
+#ifdef _WIN32
+    fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr),
+#else
+    fd(-1),
+#endif
+    opened(false), view(nullptr), fileSize(0) {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+/**
+ * @brief Opens the file for reading and determines its size.
+ *
+ * The file is only opened here; call map() afterwards to obtain a
+ * memory-mapped view. Positional reads through readAt() work either way.
+ *
+ * @param path Path of the file to open.
+ * @return true if the file was successfully opened, false otherwise.
+ */
+bool MappedFile::open(const std::string& path) {
+    close();
+#ifdef _WIN32
+    fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size)) {
+        close();
+        return false;
+    }
+    fileSize = static_cast<uint64_t>(size.QuadPart);
+#else
+    fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close();
+        return false;
+    }
+    fileSize = static_cast<uint64_t>(st.st_size);
+#endif
+    opened = true;
+    return true;
+}
+
+/**
+ * @brief Maps the whole opened file read-only into memory.
+ *
+ * Empty files cannot be mapped; callers should fall back to stream reads
+ * when this returns false.
+ *
+ * @return true if a view of the file is available through data(), false otherwise.
+ */
+bool MappedFile::map() {
+    if (!opened || fileSize == 0) {
+        return false;
+    }
+    if (view != nullptr) {
+        return true;
+    }
+#ifdef _WIN32
+    mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mappingHandle == nullptr) {
+        return false;
+    }
+    view = static_cast<const uint8_t*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (view == nullptr) {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+        return false;
+    }
+#else
+    if (static_cast<uint64_t>(static_cast<size_t>(fileSize)) != fileSize) {
+        return false;
+    }
+    void* addr = mmap(nullptr, static_cast<size_t>(fileSize), PROT_READ, MAP_SHARED, fd, 0);
+    if (addr == MAP_FAILED) {
+        return false;
+    }
+    view = static_cast<const uint8_t*>(addr);
+#endif
+    return true;
+}
+
+/**
+ * @brief Releases the mapped view and closes the file handle.
+ */
+void MappedFile::close() {
+#ifdef _WIN32
+    if (view != nullptr) {
+        UnmapViewOfFile(view);
+    }
+    if (mappingHandle != nullptr) {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+    if (fileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(fileHandle);
+        fileHandle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (view != nullptr) {
+        munmap(const_cast<uint8_t*>(view), static_cast<size_t>(fileSize));
+    }
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+    view = nullptr;
+    opened = false;
+    fileSize = 0;
+}
+
+/**
+ * @brief Copies a byte range of the file into a caller-provided buffer.
+ *
+ * Served from the mapped view when available, otherwise through a single
+ * positional read that does not disturb any shared file offset, so it may be
+ * called concurrently from several threads.
+ *
+ * @param offset Absolute file offset to start reading from.
+ * @param dst Destination buffer of at least `len` bytes.
+ * @param len Number of bytes to read.
+ * @return true if exactly `len` bytes were read, false otherwise.
+ */
+bool MappedFile::readAt(uint64_t offset, void* dst, size_t len) const {
+    if (offset > fileSize || len > fileSize - offset) {
+        return false;
+    }
+    if (view != nullptr) {
+        std::memcpy(dst, view + offset, len);
+        return true;
+    }
+    if (!opened) {
+        return false;
+    }
+    char* out = static_cast<char*>(dst);
+    while (len > 0) {
+#ifdef _WIN32
+        DWORD request = len > 0x40000000 ? 0x40000000 : static_cast<DWORD>(len);
+        OVERLAPPED ov = {};
+        ov.Offset = static_cast<DWORD>(offset);
+        ov.OffsetHigh = static_cast<DWORD>(offset >> 32);
+        DWORD got = 0;
+        if (!ReadFile(fileHandle, out, request, &got, &ov) || got == 0) {
+            return false;
+        }
+#else
+        ssize_t got = pread(fd, out, len, static_cast<off_t>(offset));
+        if (got < 0 && errno == EINTR) {
+            continue;
+        }
+        if (got <= 0) {
+            return false;
+        }
+#endif
+        out += got;
+        offset += got;
+        len -= got;
+    }
+    return true;
+}
@@ -0,0 +1,63 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstdint>
+#include <cstddef>
+
+// Read-only view of a file on disk, optionally memory-mapped
+class MappedFile {
+public:
+    // Constructor
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    // Member functions
+    bool open(const std::string& path);
+    bool map();
+    void close();
+    bool readAt(uint64_t offset, void* dst, size_t len) const;
+
+    // Getters for file details
+    bool isOpen() const {
+        return opened;
+    }
+
+    bool isMapped() const {
+        return view != nullptr;
+    }
+
+    const uint8_t* data() const {
+        return view;
+    }
+
+    uint64_t size() const {
+        return fileSize;
+    }
+
+#ifdef _WIN32
+    void* nativeHandle() const {
+        return fileHandle;
+    }
+#else
+    int nativeHandle() const {
+        return fd;
+    }
+#endif
+
+private:
+#ifdef _WIN32
+    void* fileHandle;             // Win32 file HANDLE
+    void* mappingHandle;          // Win32 file mapping HANDLE
+#else
+    int fd;                       // POSIX file descriptor
+#endif
+    bool opened;                  // Whether the file handle is valid
+    const uint8_t* view;          // Base address of the mapped view
+    uint64_t fileSize;            // Size of the file
+};
+
+#endif // MAPPEDFILE_H
@@ -0,0 +1,362 @@
+#include "MarshalReader.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+const uint8_t FLAG_REF = 0x80;
+
+} // namespace
+
+MarshalReader::MarshalReader(const uint8_t* data, size_t size, Arena& arena, uint8_t pymaj, uint8_t pymin)
+    : begin(data), cursor(data), end(data + size), arena(arena), pymaj(pymaj), pymin(pymin) {}
+
+/**
+ * @brief Decodes the next object of the stream into the arena.
+ *
+ * Containers and code objects are allocated in the arena; strings, bytes and
+ * long digits are not copied but point into the source buffer, so the result
+ * is valid as long as both the arena and the buffer are.
+ *
+ * @return The decoded object.
+ * @throws std::runtime_error If the stream is truncated or malformed.
+ */
+const MarshalObject* MarshalReader::read() {
+    return readObject(true, 0);
+}
+
+/**
+ * @brief Advances over the next object without materializing it.
+ *
+ * Nothing is allocated in the arena, which makes scans over large code
+ * objects (for example to reach a later value in a stream) cheap. Reference
+ * slots are still counted, so read() can be used afterwards; it fails only if
+ * it meets a reference to a skipped object.
+ *
+ * @throws std::runtime_error If the stream is truncated or malformed.
+ */
+void MarshalReader::skip() {
+    readObject(false, 0);
+}
+
+/**
+ * @brief Decodes or skips one object, following CPython's marshal.c.
+ *
+ * @param materialize Whether to build the object in the arena.
+ * @param depth Current nesting depth.
+ * @return The object, or nullptr when skipping.
+ */
+const MarshalObject* MarshalReader::readObject(bool materialize, int depth) {
+    if (depth > MAX_DEPTH) {
+        throw std::runtime_error("Marshal data nested too deeply");
+    }
+    uint8_t code = readByte();
+    bool flagged = (code & FLAG_REF) != 0;
+    code &= ~FLAG_REF;
+
+    if (code == 'r') {
+        uint32_t index = readUInt32();
+        if (index >= refs.size()) {
+            throw std::runtime_error("Invalid marshal reference");
+        }
+        if (materialize && refs[index] == nullptr) {
+            throw std::runtime_error("Reference to a skipped marshal object");
+        }
+        return materialize ? refs[index] : nullptr;
+    }
+    if (code == 'R') {
+        uint32_t index = readUInt32();
+        if (index >= interned.size()) {
+            throw std::runtime_error("Invalid marshal string reference");
+        }
+        if (materialize && interned[index] == nullptr) {
+            throw std::runtime_error("Reference to a skipped marshal object");
+        }
+        return materialize ? interned[index] : nullptr;
+    }
+
+    // The object is allocated before its contents so that nested references to it resolve
+    MarshalObject* object = nullptr;
+    if (materialize) {
+        object = arena.create<MarshalObject>();
+    }
+    if (flagged) {
+        refs.push_back(object);
+    }
+    MarshalObject scratch = {};
+    MarshalObject& value = materialize ? *object : scratch;
+
+    switch (code) {
+    case '0':
+        throw std::runtime_error("Unexpected marshal NULL");
+    case 'N':
+        value.type = MarshalType::None;
+        break;
+    case 'F':
+        value.type = MarshalType::False;
+        break;
+    case 'T':
+        value.type = MarshalType::True;
+        break;
+    case 'S':
+        value.type = MarshalType::StopIteration;
+        break;
+    case '.':
+        value.type = MarshalType::Ellipsis;
+        break;
+    case 'i':
+        value.type = MarshalType::Int;
+        value.integer = readInt32();
+        break;
+    case 'I': {
+        uint64_t low = readUInt32();
+        uint64_t high = readUInt32();
+        value.type = MarshalType::Int;
+        value.integer = static_cast<int64_t>(low | (high << 32));
+        break;
+    }
+    case 'l': {
+        int32_t count = readInt32();
+        uint32_t digits = count < 0 ? 0u - static_cast<uint32_t>(count) : static_cast<uint32_t>(count);
+        if (digits > static_cast<size_t>(end - cursor) / 2) {
+            throw std::runtime_error("Marshal data is truncated");
+        }
+        const uint8_t* digitData = readBytes(digits * 2);
+        if (digits <= 4) {
+            // Up to 60 bits, so the value always fits
+            uint64_t magnitude = 0;
+            for (uint32_t i = 0; i < digits; ++i) {
+                uint32_t digit = digitData[2 * i] | (digitData[2 * i + 1] << 8);
+                magnitude |= static_cast<uint64_t>(digit & 0x7FFF) << (15 * i);
+            }
+            value.type = MarshalType::Int;
+            value.integer = count < 0 ? -static_cast<int64_t>(magnitude) : static_cast<int64_t>(magnitude);
+        }
+        else {
+            value.type = MarshalType::Long;
+            value.flag = count < 0;
+            value.size = digits;
+            value.data = digitData;
+        }
+        break;
+    }
+    case 'f':
+        value.type = MarshalType::Float;
+        value.real[0] = readTextFloat();
+        break;
+    case 'g':
+        value.type = MarshalType::Float;
+        value.real[0] = readBinaryFloat();
+        break;
+    case 'x':
+        value.type = MarshalType::Complex;
+        value.real[0] = readTextFloat();
+        value.real[1] = readTextFloat();
+        break;
+    case 'y':
+        value.type = MarshalType::Complex;
+        value.real[0] = readBinaryFloat();
+        value.real[1] = readBinaryFloat();
+        break;
+    case 's':
+    case 't':
+    case 'u':
+    case 'a':
+    case 'A':
+    case 'z':
+    case 'Z': {
+        bool shortForm = code == 'z' || code == 'Z';
+        value.type = code == 's' ? MarshalType::Bytes : MarshalType::String;
+        value.flag = code == 't' || code == 'A' || code == 'Z';
+        value.size = shortForm ? readByte() : readUInt32();
+        value.data = readBytes(value.size);
+        if (code == 't' && pymaj < 3) {
+            interned.push_back(object);
+        }
+        break;
+    }
+    case '(':
+    case '[':
+    case '<':
+    case '>':
+        value.type = code == '(' ? MarshalType::Tuple : code == '[' ? MarshalType::List :
+            code == '<' ? MarshalType::Set : MarshalType::FrozenSet;
+        readItems(&value, readUInt32(), materialize, depth);
+        break;
+    case ')':
+        value.type = MarshalType::Tuple;
+        readItems(&value, readByte(), materialize, depth);
+        break;
+    case '{':
+        value.type = MarshalType::Dict;
+        readDict(&value, materialize, depth);
+        break;
+    case 'c':
+        value.type = MarshalType::Code;
+        readCode(&value, materialize, depth);
+        break;
+    default:
+        throw std::runtime_error("Unknown marshal type code");
+    }
+    return object;
+}
+
+/**
+ * @brief Reads the items of a tuple, list or set.
+ */
+void MarshalReader::readItems(MarshalObject* object, uint32_t count, bool materialize, int depth) {
+    // Every item takes at least one byte, which bounds the allocation for corrupt counts
+    if (count > static_cast<size_t>(end - cursor)) {
+        throw std::runtime_error("Marshal data is truncated");
+    }
+    const MarshalObject** items = materialize ? arena.allocateArray<const MarshalObject*>(count) : nullptr;
+    for (uint32_t i = 0; i < count; ++i) {
+        const MarshalObject* item = readObject(materialize, depth + 1);
+        if (materialize) {
+            items[i] = item;
+        }
+    }
+    object->size = count;
+    object->items = items;
+}
+
+/**
+ * @brief Reads dict entries up to the NULL terminator.
+ *
+ * The number of entries is not stored, so items are collected on a shared
+ * stack and copied into the arena once the terminator is reached.
+ */
+void MarshalReader::readDict(MarshalObject* object, bool materialize, int depth) {
+    size_t base = pending.size();
+    uint32_t pairs = 0;
+    while (true) {
+        if (cursor >= end) {
+            throw std::runtime_error("Marshal data is truncated");
+        }
+        if (*cursor == '0') {
+            ++cursor;
+            break;
+        }
+        const MarshalObject* key = readObject(materialize, depth + 1);
+        const MarshalObject* item = readObject(materialize, depth + 1);
+        if (materialize) {
+            pending.push_back(key);
+            pending.push_back(item);
+        }
+        ++pairs;
+    }
+    object->size = pairs;
+    object->items = nullptr;
+    if (materialize) {
+        const MarshalObject** items = arena.allocateArray<const MarshalObject*>(pending.size() - base);
+        std::copy(pending.begin() + base, pending.end(), items);
+        pending.resize(base);
+        object->items = items;
+    }
+}
+
+/**
+ * @brief Reads a code object using the field layout of the stream's Python version.
+ *
+ * 3.0 added kwOnlyArgCount, 3.8 posOnlyArgCount, and 3.11 replaced the
+ * separate variable tuples with localsplus names and kinds and added the
+ * qualified name and exception table.
+ */
+void MarshalReader::readCode(MarshalObject* object, bool materialize, int depth) {
+    if (pymaj == 0) {
+        throw std::runtime_error("Python version needed to decode code objects");
+    }
+    bool py3 = pymaj >= 3;
+    bool py38 = pymaj > 3 || (pymaj == 3 && pymin >= 8);
+    bool py311 = pymaj > 3 || (pymaj == 3 && pymin >= 11);
+
+    MarshalCode scratch = {};
+    MarshalCode& code = materialize ? *arena.create<MarshalCode>() : scratch;
+    auto next = [&] {
+        return readObject(materialize, depth + 1);
+    };
+
+    code.argCount = readInt32();
+    if (py38) {
+        code.posOnlyArgCount = readInt32();
+    }
+    if (py3) {
+        code.kwOnlyArgCount = readInt32();
+    }
+    if (!py311) {
+        code.nLocals = readInt32();
+    }
+    code.stackSize = readInt32();
+    code.flags = readInt32();
+    code.bytecode = next();
+    code.consts = next();
+    code.names = next();
+    if (py311) {
+        code.localsPlusNames = next();
+        code.localsPlusKinds = next();
+    }
+    else {
+        code.varNames = next();
+        code.freeVars = next();
+        code.cellVars = next();
+    }
+    code.fileName = next();
+    code.name = next();
+    if (py311) {
+        code.qualName = next();
+    }
+    code.firstLineNo = readInt32();
+    code.lineTable = next();
+    if (py311) {
+        code.exceptionTable = next();
+    }
+    object->code = materialize ? &code : nullptr;
+}
+
+uint8_t MarshalReader::readByte() {
+    if (cursor >= end) {
+        throw std::runtime_error("Marshal data is truncated");
+    }
+    return *cursor++;
+}
+
+uint32_t MarshalReader::readUInt32() {
+    const uint8_t* p = readBytes(4);
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+int32_t MarshalReader::readInt32() {
+    return static_cast<int32_t>(readUInt32());
+}
+
+const uint8_t* MarshalReader::readBytes(size_t len) {
+    if (static_cast<size_t>(end - cursor) < len) {
+        throw std::runtime_error("Marshal data is truncated");
+    }
+    const uint8_t* p = cursor;
+    cursor += len;
+    return p;
+}
+
+// Pre-2.5 floats are stored as a length-prefixed decimal string
+double MarshalReader::readTextFloat() {
+    uint8_t len = readByte();
+    char text[256];
+    std::memcpy(text, readBytes(len), len);
+    text[len] = '\0';
+    return std::strtod(text, nullptr);
+}
+
+double MarshalReader::readBinaryFloat() {
+    const uint8_t* p = readBytes(8);
+    uint64_t bits = 0;
+    for (int i = 7; i >= 0; --i) {
+        bits = (bits << 8) | p[i];
+    }
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
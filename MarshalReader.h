@@ -0,0 +1,127 @@
+#ifndef MARSHALREADER_H
+#define MARSHALREADER_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string_view>
+#include <vector>
+#include "Arena.h"
+
+// Kinds of values a marshal stream can hold
+enum class MarshalType : uint8_t {
+    Null,                          // Terminator used inside dicts, never returned
+    None,
+    False,
+    True,
+    StopIteration,
+    Ellipsis,
+    Int,                           // Also longs that fit in 64 bits
+    Long,                          // Larger longs, kept as raw 15-bit digits
+    Float,
+    Complex,
+    Bytes,
+    String,
+    Tuple,
+    List,
+    Dict,                          // Items alternate keys and values, size counts pairs
+    Set,
+    FrozenSet,
+    Code
+};
+
+struct MarshalCode;
+
+// Decoded marshal value; strings and long digits point into the source buffer
+struct MarshalObject {
+    MarshalType type;              // Kind of value
+    bool flag;                     // Interned for strings, negative for longs
+    uint32_t size;                 // Bytes of a string, digits of a long, items of a container
+    union {
+        int64_t integer;           // Int
+        double real[2];            // Float, Complex (real, imaginary)
+        const uint8_t* data;       // Bytes, String, Long digits
+        const MarshalObject* const* items; // Tuple, List, Set, FrozenSet, Dict
+        const MarshalCode* code;   // Code
+    };
+
+    std::string_view text() const {
+        return std::string_view(reinterpret_cast<const char*>(data), size);
+    }
+
+    bool isString() const {
+        return type == MarshalType::String || type == MarshalType::Bytes;
+    }
+
+    bool isSequence() const {
+        return type == MarshalType::Tuple || type == MarshalType::List;
+    }
+};
+
+// Decoded code object; fields that the Python version does not have are 0 or nullptr
+struct MarshalCode {
+    int32_t argCount;
+    int32_t posOnlyArgCount;       // 3.8+
+    int32_t kwOnlyArgCount;        // 3.0+
+    int32_t nLocals;               // Before 3.11
+    int32_t stackSize;
+    int32_t flags;
+    int32_t firstLineNo;
+    const MarshalObject* bytecode;
+    const MarshalObject* consts;
+    const MarshalObject* names;
+    const MarshalObject* varNames;  // Before 3.11
+    const MarshalObject* freeVars;  // Before 3.11
+    const MarshalObject* cellVars;  // Before 3.11
+    const MarshalObject* localsPlusNames; // 3.11+
+    const MarshalObject* localsPlusKinds; // 3.11+
+    const MarshalObject* fileName;
+    const MarshalObject* name;
+    const MarshalObject* qualName;  // 3.11+
+    const MarshalObject* lineTable; // lnotab before 3.10
+    const MarshalObject* exceptionTable; // 3.11+
+};
+
+// Decoder for Python marshal streams that allocates the object graph in an arena
+class MarshalReader {
+public:
+    // Constructor; the Python version selects the code object layout
+    MarshalReader(const uint8_t* data, size_t size, Arena& arena, uint8_t pymaj, uint8_t pymin);
+
+    // Member functions
+    const MarshalObject* read();
+    void skip();
+
+    size_t position() const {
+        return static_cast<size_t>(cursor - begin);
+    }
+
+    bool atEnd() const {
+        return cursor == end;
+    }
+
+private:
+    const MarshalObject* readObject(bool materialize, int depth);
+    void readItems(MarshalObject* object, uint32_t count, bool materialize, int depth);
+    void readDict(MarshalObject* object, bool materialize, int depth);
+    void readCode(MarshalObject* object, bool materialize, int depth);
+    int32_t readInt32();
+    uint8_t readByte();
+    uint32_t readUInt32();
+    const uint8_t* readBytes(size_t len);
+    double readTextFloat();
+    double readBinaryFloat();
+
+    const uint8_t* begin;          // Start of the stream
+    const uint8_t* cursor;         // Next byte to decode
+    const uint8_t* end;            // End of the stream
+    Arena& arena;                  // Storage for decoded objects
+    uint8_t pymaj;                 // Python major version of the stream
+    uint8_t pymin;                 // Python minor version of the stream
+    std::vector<MarshalObject*> refs; // FLAG_REF objects by index, nullptr for skipped ones
+    std::vector<const MarshalObject*> interned; // Python 2 interned strings by 'R' index
+    std::vector<const MarshalObject*> pending; // Stack of dict items whose count is not known yet
+
+    static const int MAX_DEPTH = 512;
+};
+
+#endif // MARSHALREADER_H
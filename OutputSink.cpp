@@ -0,0 +1,318 @@
+#include "OutputSink.h"
+#include <algorithm>
+#include <string>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+#endif
+
+/**
+ * @brief Maps a TOC entry name to a path below the output directory.
+ *
+ * Both `/` and `\\` are treated as separators. Empty and `.` components are
+ * dropped, `..` components are replaced and drive colons are escaped, so that
+ * a crafted archive cannot write outside the output directory. A name with no
+ * component left, such as `.`, is replaced the same way rather than
+ * resolving to the output directory itself.
+ *
+ * @param outputDir The extraction root.
+ * @param name The entry name from the TOC.
+ * @return The path of the output file.
+ */
+std::filesystem::path entryOutputPath(const std::filesystem::path& outputDir, std::string_view name) {
+    std::filesystem::path path = outputDir;
+    size_t start = 0;
+    while (start <= name.size()) {
+        size_t end = name.find_first_of("/\\", start);
+        if (end == std::string_view::npos) {
+            end = name.size();
+        }
+        std::string component(name.substr(start, end - start));
+        std::replace(component.begin(), component.end(), ':', '_');
+        if (component == "..") {
+            component = "__";
+        }
+        if (!component.empty() && component != ".") {
+            path /= std::filesystem::u8path(component);
+        }
+        start = end + 1;
+    }
+    if (path == outputDir) {
+        path /= "__";
+    }
+    return path;
+}
+
+/**
+ * @brief Appends bytes to the buffer.
+ *
+ * @param data Bytes to append.
+ * @param len Number of bytes to append.
+ * @return Always true.
+ */
+bool BufferSink::write(const uint8_t* data, size_t len) {
+    buffer.insert(buffer.end(), data, data + len);
+    return true;
+}
+
+/**
+ * @brief Finishes the buffer; the bytes stay available through getBuffer().
+ *
+ * @return Always true.
+ */
+bool BufferSink::commit() {
+    return true;
+}
+
+ProbeSink::ProbeSink(OutputSink& target, size_t headSize, size_t tailSize)
+    : target(target), headSize(headSize), tailSize(tailSize) {
+    head.reserve(headSize);
+}
+
+/**
+ * @brief Forwards bytes to the target and keeps the ones the probe needs.
+ *
+ * @param data Bytes to append.
+ * @param len Number of bytes to append.
+ * @return The result of the target's write.
+ */
+bool ProbeSink::write(const uint8_t* data, size_t len) {
+    keepHead(data, len);
+    keepTail(data, len);
+    return target.write(data, len);
+}
+
+/**
+ * @brief Forwards a kernel copy to the target and reads back only the bytes
+ *        the probe needs from the source file.
+ *
+ * @param source File to copy from.
+ * @param offset Start of the range in `source`.
+ * @param length Number of bytes to copy.
+ * @return Number of bytes the target copied.
+ */
+uint64_t ProbeSink::copyFrom(const MappedFile& source, uint64_t offset, uint64_t length) {
+    uint64_t copied = target.copyFrom(source, offset, length);
+    std::vector<uint8_t> bytes;
+    if (head.size() < headSize && copied > 0) {
+        bytes.resize(static_cast<size_t>(std::min<uint64_t>(headSize - head.size(), copied)));
+        if (source.readAt(offset, bytes.data(), bytes.size())) {
+            keepHead(bytes.data(), bytes.size());
+        }
+    }
+    if (copied > 0) {
+        bytes.resize(static_cast<size_t>(std::min<uint64_t>(tailSize, copied)));
+        if (!source.readAt(offset + copied - bytes.size(), bytes.data(), bytes.size())) {
+            std::fill(bytes.begin(), bytes.end(), uint8_t(0));
+        }
+        keepTail(bytes.data(), bytes.size());
+    }
+    return copied;
+}
+
+/**
+ * @brief Finishes the target.
+ *
+ * @return The result of the target's commit.
+ */
+bool ProbeSink::commit() {
+    return target.commit();
+}
+
+/**
+ * @brief Returns the last bytes written, at most tailSize of them.
+ */
+const uint8_t* ProbeSink::tailData() const {
+    return tail.data() + (tail.size() - tailLength());
+}
+
+size_t ProbeSink::tailLength() const {
+    return std::min(tail.size(), tailSize);
+}
+
+void ProbeSink::keepHead(const uint8_t* data, size_t len) {
+    size_t wanted = std::min(headSize - head.size(), len);
+    head.insert(head.end(), data, data + wanted);
+}
+
+void ProbeSink::keepTail(const uint8_t* data, size_t len) {
+    if (len >= tailSize) {
+        tail.assign(data + (len - tailSize), data + len);
+        return;
+    }
+    tail.insert(tail.end(), data, data + len);
+    if (tail.size() > 2 * tailSize) {
+        tail.erase(tail.begin(), tail.end() - tailSize);
+    }
+}
+
+FileSink::FileSink(const std::filesystem::path& path)
+    : path(path), partPath(std::filesystem::path(path) += ".part"),
+#ifdef _WIN32
+    fileHandle(INVALID_HANDLE_VALUE),
+#else
+    fd(-1),
+#endif
+    failed(false), committed(false) {}
+
+/**
+ * @brief Closes the file and removes it unless it was committed.
+ */
+FileSink::~FileSink() {
+    closeHandle();
+    if (!committed) {
+        std::error_code ec;
+        std::filesystem::remove(partPath, ec);
+    }
+}
+
+/**
+ * @brief Creates the `.part` file and any missing parent directories.
+ *
+ * @return true if the file is ready for writing, false otherwise.
+ */
+bool FileSink::open() {
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+#ifdef _WIN32
+    fileHandle = CreateFileW(partPath.c_str(), GENERIC_WRITE, 0, nullptr, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    return fileHandle != INVALID_HANDLE_VALUE;
+#else
+    fd = ::open(partPath.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    return fd >= 0;
+#endif
+}
+
+/**
+ * @brief Appends bytes to the destination file.
+ *
+ * @param data Bytes to write.
+ * @param len Number of bytes to write.
+ * @return true if the bytes were written, false otherwise.
+ */
+bool FileSink::write(const uint8_t* data, size_t len) {
+    while (len > 0 && !failed) {
+#ifdef _WIN32
+        DWORD request = len > 0x40000000 ? 0x40000000 : static_cast<DWORD>(len);
+        DWORD written = 0;
+        if (!WriteFile(fileHandle, data, request, &written, nullptr) || written == 0) {
+            failed = true;
+            break;
+        }
+#else
+        ssize_t written = ::write(fd, data, len);
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            failed = true;
+            break;
+        }
+#endif
+        data += written;
+        len -= written;
+    }
+    return !failed;
+}
+
+/**
+ * @brief Copies a byte range of the archive into the file inside the kernel.
+ *
+ * On Linux this uses copy_file_range(), which can share extents on
+ * filesystems with reflink support, and falls back to sendfile() when the
+ * two files cannot be used with it. Other platforms report that nothing was
+ * copied so the caller writes the range through write() instead.
+ *
+ * @param source The archive, opened with a native handle.
+ * @param offset Start of the range in the archive.
+ * @param length Number of bytes to copy.
+ * @return Number of bytes appended to the file; less than `length` if the kernel path is unavailable.
+ */
+uint64_t FileSink::copyFrom(const MappedFile& source, uint64_t offset, uint64_t length) {
+#ifdef __linux__
+    if (failed || !source.isOpen()) {
+        return 0;
+    }
+    uint64_t copied = 0;
+    bool useSendfile = false;
+    while (copied < length) {
+        size_t request = static_cast<size_t>(std::min<uint64_t>(length - copied, 0x40000000));
+        off_t inOffset = static_cast<off_t>(offset + copied);
+        ssize_t result;
+        if (!useSendfile) {
+            result = copy_file_range(source.nativeHandle(), &inOffset, fd, nullptr, request, 0);
+            if (result < 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP)) {
+                useSendfile = true;
+                continue;
+            }
+        }
+        else {
+            result = sendfile(fd, source.nativeHandle(), &inOffset, request);
+        }
+        if (result < 0 && errno == EINTR) {
+            continue;
+        }
+        if (result <= 0) {
+            break;
+        }
+        copied += static_cast<uint64_t>(result);
+    }
+    return copied;
+#else
+    return 0;
+#endif
+}
+
+/**
+ * @brief Closes the file and renames it to its final name.
+ *
+ * The rename replaces any older file atomically, so the destination path only
+ * ever holds a complete output. A failed file is removed instead.
+ *
+ * @return true if all data reached the file and it was renamed, false otherwise.
+ */
+bool FileSink::commit() {
+#ifdef _WIN32
+    if (fileHandle == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+#else
+    if (fd < 0) {
+        return false;
+    }
+#endif
+    closeHandle();
+    if (failed) {
+        return false;
+    }
+    std::error_code ec;
+    std::filesystem::rename(partPath, path, ec);
+    committed = !ec;
+    return committed;
+}
+
+/**
+ * @brief Closes the native handle if it is open.
+ */
+void FileSink::closeHandle() {
+#ifdef _WIN32
+    if (fileHandle != INVALID_HANDLE_VALUE) {
+        CloseHandle(fileHandle);
+        fileHandle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (fd >= 0) {
+        if (::close(fd) != 0) {
+            failed = true;
+        }
+        fd = -1;
+    }
+#endif
+}
@@ -0,0 +1,106 @@
+#ifndef OUTPUTSINK_H
+#define OUTPUTSINK_H
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <string_view>
+#include <vector>
+#include "MappedFile.h"
+
+// Destination for the bytes of one extracted entry
+class OutputSink {
+public:
+    virtual ~OutputSink() = default;
+
+    // Appends bytes to the output
+    virtual bool write(const uint8_t* data, size_t len) = 0;
+
+    // Appends a byte range of another file without passing it through user space,
+    // returning how many bytes were copied; the caller writes the rest itself
+    virtual uint64_t copyFrom(const MappedFile& /*source*/, uint64_t /*offset*/, uint64_t /*length*/) {
+        return 0;
+    }
+
+    // Finishes the output after the last write
+    virtual bool commit() = 0;
+};
+
+// Sink collecting the output in memory
+class BufferSink : public OutputSink {
+public:
+    bool write(const uint8_t* data, size_t len) override;
+    bool commit() override;
+
+    std::vector<uint8_t>& getBuffer() {
+        return buffer;
+    }
+
+private:
+    std::vector<uint8_t> buffer;   // Bytes written so far
+};
+
+// Sink forwarding to another one while keeping the first and last bytes written,
+// so a streamed entry can be checked for a nested archive without buffering it
+class ProbeSink : public OutputSink {
+public:
+    // Constructor
+    ProbeSink(OutputSink& target, size_t headSize, size_t tailSize);
+
+    // Member functions
+    bool write(const uint8_t* data, size_t len) override;
+    uint64_t copyFrom(const MappedFile& source, uint64_t offset, uint64_t length) override;
+    bool commit() override;
+
+    const std::vector<uint8_t>& getHead() const {
+        return head;
+    }
+    const uint8_t* tailData() const;
+    size_t tailLength() const;
+
+private:
+    void keepHead(const uint8_t* data, size_t len);
+    void keepTail(const uint8_t* data, size_t len);
+
+    OutputSink& target;            // Sink receiving the bytes
+    size_t headSize;               // Number of leading bytes kept
+    size_t tailSize;               // Number of trailing bytes kept
+    std::vector<uint8_t> head;     // First bytes of the output
+    std::vector<uint8_t> tail;     // Last bytes, compacted once twice tailSize
+};
+
+// Sink writing to a regular file, creating missing parent directories; the file
+// is written as `<path>.part` and only renamed to `path` once it is complete
+class FileSink : public OutputSink {
+public:
+    // Constructor
+    explicit FileSink(const std::filesystem::path& path);
+    ~FileSink() override;
+
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    // Member functions
+    bool open();
+    bool write(const uint8_t* data, size_t len) override;
+    uint64_t copyFrom(const MappedFile& source, uint64_t offset, uint64_t length) override;
+    bool commit() override;
+
+private:
+    void closeHandle();
+
+    std::filesystem::path path;    // Destination file
+    std::filesystem::path partPath; // File being written until commit
+#ifdef _WIN32
+    void* fileHandle;              // Win32 file HANDLE
+#else
+    int fd;                        // POSIX file descriptor
+#endif
+    bool failed;                   // Set when a write failed
+    bool committed;                // Set once the file has been renamed to path
+};
+
+// Maps an archive member name to a path that cannot escape `outputDir`
+std::filesystem::path entryOutputPath(const std::filesystem::path& outputDir, std::string_view name);
+
+#endif // OUTPUTSINK_H
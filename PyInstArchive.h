@@ -1,71 +1,250 @@
-#ifndef PYINSTARCHIVE_H
-#define PYINSTARCHIVE_H
-
-#include <iostream>
-#include <fstream>
-#include <vector>
-#include <string>
-#include <cstring>
-#include <cstdint> 
-
-// Structure for Table of Contents Entry
-struct CTOCEntry {
-    uint32_t position;              // Position of the entry
-    uint32_t cmprsdDataSize;       // Compressed data size
-    uint32_t uncmprsdDataSize;     // Uncompressed data size
-    uint8_t cmprsFlag;             // Compression flag
-    char typeCmprsData;            // Type of compressed data
-    std::string name;              // Name of the entry
-
-    // Constructor
-    CTOCEntry(uint32_t pos, uint32_t cmprsdSize, uint32_t uncmprsdSize, uint8_t flag, char type, const std::string& n)
-        : position(pos), cmprsdDataSize(cmprsdSize), uncmprsdDataSize(uncmprsdSize), cmprsFlag(flag), typeCmprsData(type), name(n) {}
-
-    // Getters for entry details
-    uint32_t getCompressedDataSize() const {
-        return cmprsdDataSize; 
-    }
-
-    const std::string& getName() const {
-        return name; 
-    }
-};
-
-// Class for handling the PyInstaller Archive
-class PyInstArchive {
-public:
-    // Constructor
-    PyInstArchive(const std::string& path);
-
-    // Member functions
-    bool open();
-    void close();
-    bool checkFile();
-    bool getCArchiveInfo();
-    void parseTOC();
-    void viewFiles();
-
-private:
-    std::string filePath;          // Path to the archive file
-    std::ifstream fPtr;           // File stream for reading the archive
-    uint64_t fileSize;            // Size of the file
-    uint64_t cookiePos;           // Position of the cookie
-    uint64_t overlayPos;          // Position of the overlay
-    uint64_t overlaySize;         // Size of the overlay
-    uint64_t tableOfContentsPos;  // Position of the TOC
-    uint64_t tableOfContentsSize; // Size of the TOC
-    uint8_t pyinstVer;            // PyInstaller version
-    uint8_t pymaj;                // Python major version
-    uint8_t pymin;                // Python minor version
-    std::vector<CTOCEntry> tocList; // List of TOC entries
-    uint32_t lengthofPackage;     // Length of the package
-    uint32_t toc;                 // Table of contents
-    uint32_t tocLen;              // Length of the table of contents
-
-    // Constants for PyInstaller cookie sizes
-    static const uint8_t PYINST20_COOKIE_SIZE = 24;
-    static const uint8_t PYINST21_COOKIE_SIZE = 24 + 64;
-    static const std::string MAGIC;
-};
-
-#endif // PYINSTARCHIVE_H
+#ifndef PYINSTARCHIVE_H
+#define PYINSTARCHIVE_H
+
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <cstdint> 
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <optional>
+#include <string_view>
+#include "MappedFile.h"
+#include "TocTable.h"
+#include "ThreadPool.h"
+#include "Decompressor.h"
+#include "OutputSink.h"
+#include "EntryFilter.h"
+#include "ContentStore.h"
+#include "ExtractManifest.h"
+
+// Structure for Table of Contents Entry
+struct CTOCEntry {
+    uint32_t position;              // Position of the entry
+    uint32_t cmprsdDataSize;       // Compressed data size
+    uint32_t uncmprsdDataSize;     // Uncompressed data size
+    uint8_t cmprsFlag;             // Compression flag
+    char typeCmprsData;            // Type of compressed data
+    std::string name;              // Name of the entry
+
+    // Constructor
+    CTOCEntry(uint32_t pos, uint32_t cmprsdSize, uint32_t uncmprsdSize, uint8_t flag, char type, const std::string& n)
+        : position(pos), cmprsdDataSize(cmprsdSize), uncmprsdDataSize(uncmprsdSize), cmprsFlag(flag), typeCmprsData(type), name(n) {}
+
+    // Getters for entry details
+    uint64_t getPosition() const {
+        return position;
+    }
+
+    uint32_t getCompressedDataSize() const {
+        return cmprsdDataSize; 
+    }
+
+    uint32_t getUncompressedDataSize() const {
+        return uncmprsdDataSize;
+    }
+
+    uint8_t getCompressionFlag() const {
+        return cmprsFlag;
+    }
+
+    char getType() const {
+        return typeCmprsData;
+    }
+
+    const std::string& getName() const {
+        return name; 
+    }
+};
+
+// Parsed CArchive metadata, filled by checkFile() and getCArchiveInfo()
+struct ArchiveInfo {
+    std::string filePath;          // Path to the archive file
+    uint64_t fileSize = 0;         // Size of the file
+    uint8_t pyinstVer = 0;         // PyInstaller version (20 or 21)
+    uint8_t pymaj = 0;             // Python major version
+    uint8_t pymin = 0;             // Python minor version
+    uint32_t lengthofPackage = 0;  // Length of the package
+    uint64_t cookiePos = 0;        // Position of the cookie
+    uint64_t overlayPos = 0;       // Position of the overlay
+    uint64_t overlaySize = 0;      // Size of the overlay
+    uint64_t tableOfContentsPos = 0;  // Position of the TOC
+    uint64_t tableOfContentsSize = 0; // Size of the TOC
+    const TocTable* entries = nullptr; // Entry table, owned by the archive
+};
+
+// Settings for extractAll()
+struct ExtractOptions {
+    unsigned threads = 0;          // Worker threads, 0 for one per hardware thread
+    InflateBackend inflateBackend = InflateBackend::Auto; // Decompressor for compressed entries
+    uint64_t streamingThreshold = 16 * 1024 * 1024; // Larger compressed entries are inflated in chunks
+    size_t streamChunkSize = 256 * 1024; // Chunk size for streamed reads and inflate output
+    bool kernelCopy = true;        // Copy stored entries with copy_file_range/sendfile where supported
+    EntryFilter filter;            // Entries to extract, all by default
+    bool pycHeaders = true;        // Write scripts ('s') as .pyc files with a header for the archive's Python version
+    bool extractPyz = true;        // Also extract the modules of PYZ entries ('z') into <name>_extracted
+    std::string pyzKey;            // Key of encrypted PYZ archives, read from pyimod00_crypto_key when empty
+    unsigned maxNestingDepth = 4;  // Levels of archives inside entries to expand, 0 to write entries only
+    std::string contentStore;      // Store outputs once by SHA-256 in this directory, with a manifest in the output directory
+    bool incremental = false;      // Keep a manifest in the output directory and skip entries unchanged since the last run
+    bool resume = false;           // Journal finished outputs in the output directory and skip them when an interrupted run is repeated
+
+    std::string outputSettings() const;
+};
+
+// Outcome of the last extractAll() run
+struct ExtractionStats {
+    size_t files = 0;              // Entries scheduled for extraction, and outputs kept below unchanged archives
+    size_t skipped = 0;            // Entries rejected by the filter
+    size_t failures = 0;           // Entries that could not be extracted
+    size_t nestedArchives = 0;     // PYZ and CArchives found inside entries and expanded
+    size_t unchanged = 0;          // Outputs left as they were because they match the manifest, not counted as extracted
+    double wallSeconds = 0;        // Wall time of the whole run
+    std::vector<WorkerStats> workers; // Per-thread task counts and utilization
+};
+
+struct PendingRecord;
+
+// Shared state of one extraction run, across the archive on disk and the archives nested in it
+struct ExtractionContext {
+    ThreadPool& pool;              // Workers for every entry and module
+    const Decompressor& decompressor; // Inflate backend
+    const ExtractOptions& options; // Settings of the run
+    std::atomic<size_t> files{0};  // Entries and modules scheduled, and outputs kept below unchanged archives
+    std::atomic<size_t> failures{0}; // Entries and modules that could not be extracted
+    std::atomic<size_t> nestedArchives{0}; // Archives found inside entries
+    ContentStore* store = nullptr; // Destination of the outputs instead of the output tree, if set
+    std::filesystem::path outputRoot{}; // Output directory of the archive on disk, base of manifest names
+    ExtractManifest* manifest = nullptr; // Outputs of the previous and current run, if incremental or resumable
+    std::atomic<size_t> unchanged{0}; // Outputs skipped because they match the manifest
+    bool sameSource = false;       // The manifest was written for this very archive file, so TOC fields identify its records
+
+    std::unique_ptr<OutputSink> openSink(const std::filesystem::path& path);
+    std::string knownHash(const std::filesystem::path& path, uint64_t compressedSize, uint64_t position) const;
+    bool isUnchanged(const std::filesystem::path& path, uint64_t compressedSize, const std::string& hash, PendingRecord* parent);
+    std::shared_ptr<PendingRecord> recordOutput(const std::filesystem::path& path, uint64_t compressedSize, uint64_t position, const std::string& hash, const std::shared_ptr<PendingRecord>& parent);
+};
+
+// Manifest record of an output, written once the last reference is released; tasks for the
+// outputs of an archive expanded from it hold references, so it waits for all of them
+struct PendingRecord {
+    ExtractionContext& context;    // Run whose manifest receives the record
+    ManifestEntry entry;           // The record, `children` filled in on release
+    std::shared_ptr<PendingRecord> parent; // Record of the entry holding this output's archive, if nested
+    std::atomic<uint64_t> children{0}; // Outputs recorded below this one so far
+    std::atomic<bool> incomplete{false}; // Set when an output below this one failed or was not recorded
+
+    PendingRecord(ExtractionContext& context, ManifestEntry entry, std::shared_ptr<PendingRecord> parent);
+    ~PendingRecord();
+
+    PendingRecord(const PendingRecord&) = delete;
+    PendingRecord& operator=(const PendingRecord&) = delete;
+};
+
+// Sets up the store, manifest and pool of one extraction into `outputDir`, runs the work `schedule` submits and logs the outcome
+bool runExtraction(const std::filesystem::path& outputDir, const ExtractOptions& options, const std::string& source, const std::function<void(ExtractionContext&)>& schedule, ExtractionStats& stats);
+
+// Callback interface for walking the TOC entries
+class TocVisitor {
+public:
+    virtual ~TocVisitor() = default;
+    virtual void visit(const TocTable::Entry& entry) = 0;
+};
+
+// Class for handling the PyInstaller Archive
+class PyInstArchive {
+public:
+    // Constructors, for a file on disk or for an archive already in memory (nested in another one)
+    PyInstArchive(const std::string& path, bool useMmap = true);
+    PyInstArchive(const uint8_t* data, size_t size, const std::string& name, std::shared_ptr<const void> dataOwner = nullptr);
+    PyInstArchive(std::vector<uint8_t>&& buffer, const std::string& name);
+
+    // Member functions
+    bool open();
+    void close();
+    bool checkFile();
+    bool getCArchiveInfo();
+    void parseTOC();
+    void viewFiles();
+    const uint8_t* getEntryData(const CTOCEntry& entry) const;
+    const uint8_t* getEntryData(const TocTable::Entry& entry) const;
+
+    std::optional<TocTable::Entry> findEntry(std::string_view name) const;
+    ArchiveInfo getArchiveInfo() const;
+    bool extractAll(const std::string& outputDir, unsigned threads = 0);
+    bool extractAll(const std::string& outputDir, const ExtractOptions& options);
+
+    const ExtractionStats& getExtractionStats() const {
+        return extractionStats;
+    }
+    void visitEntries(TocVisitor& visitor) const;
+
+    // Calls `callback(const TocTable::Entry&)` for every entry without virtual dispatch
+    template <typename Callback>
+    void forEachEntry(Callback&& callback) const {
+        for (const auto& entry : tocList) {
+            callback(entry);
+        }
+    }
+
+    // Parsed Table of Contents
+    const TocTable& getTOC() const {
+        return tocList;
+    }
+    void setTailPrefetchSize(size_t bytes);
+
+private:
+    bool readAt(uint64_t offset, void* dst, size_t len);
+    const uint8_t* viewAt(uint64_t offset, uint64_t len) const;
+    const uint8_t* loadEntryData(const TocTable::Entry& entry, std::vector<uint8_t>& buffer);
+    InflateSource rangeSource(uint64_t offset, uint64_t remaining, size_t chunkSize, std::vector<uint8_t>& buffer);
+    std::string hashEntry(const TocTable::Entry& entry, size_t chunkSize);
+    bool writeEntryPayload(const TocTable::Entry& entry, OutputSink& sink, const Decompressor& decompressor, const ExtractOptions& options);
+    size_t scheduleEntries(ExtractionContext& context, const std::filesystem::path& outputDir, unsigned depth, const std::shared_ptr<const void>& keepAlive, const std::shared_ptr<PendingRecord>& parent);
+    bool extractEntry(const TocTable::Entry& entry, const std::filesystem::path& outputDir, ExtractionContext& context, unsigned depth, const std::shared_ptr<const void>& keepAlive, const std::shared_ptr<PendingRecord>& parent);
+    bool expandNested(const std::filesystem::path& path, const uint8_t* payload, size_t size, std::vector<uint8_t>& decoded, ExtractionContext& context, unsigned depth, const std::shared_ptr<const void>& keepAlive, const std::shared_ptr<PendingRecord>& record);
+    bool expandFromOutput(const TocTable::Entry& entry, const std::filesystem::path& path, ExtractionContext& context, unsigned depth, const std::shared_ptr<PendingRecord>& record);
+    std::string findCryptoKey(const Decompressor& decompressor, const ExtractOptions& options);
+
+    std::string filePath;          // Path to the archive file
+    std::ifstream fPtr;           // File stream for reading the archive
+    std::mutex streamMutex;       // Serializes seek/read pairs on fPtr
+    bool useMmap;                 // Whether to try memory-mapping the archive
+    bool inMemory;                // Whether the archive is a buffer rather than a file
+    std::vector<uint8_t> ownedData; // Bytes of an in-memory archive that owns them
+    std::shared_ptr<const void> dataOwner; // Keeps borrowed in-memory bytes alive, may be null
+    MappedFile mappedFile;        // Memory-mapped view of the archive, or just its native handle in stream mode
+    const uint8_t* fileData;      // Start of the mapped archive, or nullptr
+    size_t tailPrefetchSize;      // Bytes read from the end of the file on open
+    std::vector<uint8_t> tailBuffer; // Prefetched tail of the file (stream mode)
+    uint64_t tailPos;             // File offset of the first byte in tailBuffer
+    uint64_t fileSize;            // Size of the file
+    uint64_t cookiePos;           // Position of the cookie
+    uint64_t overlayPos;          // Position of the overlay
+    uint64_t overlaySize;         // Size of the overlay
+    uint64_t tableOfContentsPos;  // Position of the TOC
+    uint64_t tableOfContentsSize; // Size of the TOC
+    uint8_t pyinstVer;            // PyInstaller version
+    uint8_t pymaj;                // Python major version
+    uint8_t pymin;                // Python minor version
+    TocTable tocList;             // Columnar list of TOC entries
+    uint32_t lengthofPackage;     // Length of the package
+    uint32_t toc;                 // Table of contents
+    uint32_t tocLen;              // Length of the table of contents
+    ExtractionStats extractionStats; // Statistics of the last extractAll() run
+
+    // Constants for PyInstaller cookie sizes
+    static const uint8_t PYINST20_COOKIE_SIZE = 24;
+    static const uint8_t PYINST21_COOKIE_SIZE = 24 + 64;
+    static const size_t DEFAULT_TAIL_PREFETCH_SIZE = 512 * 1024;
+    static const size_t NESTED_COOKIE_WINDOW = 64 * 1024; // Tail of an entry searched for a CArchive cookie
+    static const size_t NESTED_HEAD_SIZE = 16; // Start of a streamed entry checked for a PYZ header
+    static const std::string MAGIC;
+};
+
+#endif // PYINSTARCHIVE_H
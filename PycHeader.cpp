@@ -0,0 +1,23 @@
+#include "PycHeader.h"
+#include <cstring>
+
+/**
+ * @brief Writes the pyc header of a Python version into a buffer.
+ *
+ * The header starts with the two-byte magic number in little-endian order and
+ * `\r\n`. The remaining fields (flags on 3.7+, modification time, and source
+ * size on 3.3+) are not recorded in the archive and are left zero; decompilers
+ * only use the magic to pick the bytecode version.
+ *
+ * @param format The pyc format from PYC_FORMATS.
+ * @param out Destination of at least MAX_PYC_HEADER_SIZE bytes.
+ * @return Number of header bytes written.
+ */
+size_t buildPycHeader(const PycFormat& format, uint8_t* out) {
+    std::memset(out, 0, format.headerSize);
+    out[0] = static_cast<uint8_t>(format.magic & 0xFF);
+    out[1] = static_cast<uint8_t>(format.magic >> 8);
+    out[2] = '\r';
+    out[3] = '\n';
+    return format.headerSize;
+}
@@ -0,0 +1,65 @@
+#ifndef PYCHEADER_H
+#define PYCHEADER_H
+
+#include <cstdint>
+#include <cstddef>
+
+// Largest pyc header, used by Python 3.7+ (magic, flags, mtime, source size)
+const size_t MAX_PYC_HEADER_SIZE = 16;
+
+// Pyc magic number and header layout of one Python release
+struct PycFormat {
+    uint8_t major;                 // Python major version
+    uint8_t minor;                 // Python minor version
+    uint16_t magic;                // Magic number, stored little-endian and followed by "\r\n"
+    uint8_t headerSize;            // 8 (magic, mtime), 12 (+ source size) or 16 (+ flags)
+};
+
+// Final-release magic numbers as listed in CPython's importlib/_bootstrap_external.py
+constexpr PycFormat PYC_FORMATS[] = {
+    { 2, 5, 62131, 8 },
+    { 2, 6, 62161, 8 },
+    { 2, 7, 62211, 8 },
+    { 3, 0, 3131, 8 },
+    { 3, 1, 3151, 8 },
+    { 3, 2, 3180, 8 },
+    { 3, 3, 3230, 12 },
+    { 3, 4, 3310, 12 },
+    { 3, 5, 3351, 12 },
+    { 3, 6, 3379, 12 },
+    { 3, 7, 3394, 16 },
+    { 3, 8, 3413, 16 },
+    { 3, 9, 3425, 16 },
+    { 3, 10, 3439, 16 },
+    { 3, 11, 3495, 16 },
+    { 3, 12, 3531, 16 },
+    { 3, 13, 3571, 16 },
+};
+
+// Looks up the pyc format of a Python version, or nullptr if it is not known
+constexpr const PycFormat* findPycFormat(uint8_t major, uint8_t minor) {
+    for (const PycFormat& format : PYC_FORMATS) {
+        if (format.major == major && format.minor == minor) {
+            return &format;
+        }
+    }
+    return nullptr;
+}
+
+// Looks up the pyc format that uses a magic number, or nullptr if it is not known
+constexpr const PycFormat* findPycFormatByMagic(uint16_t magic) {
+    for (const PycFormat& format : PYC_FORMATS) {
+        if (format.magic == magic) {
+            return &format;
+        }
+    }
+    return nullptr;
+}
+
+static_assert(findPycFormat(3, 7)->headerSize == 16, "Python 3.7 introduced the flags field");
+static_assert(findPycFormat(3, 3)->headerSize == 12, "Python 3.3 introduced the source size field");
+
+// Writes a pyc header with zeroed flags, mtime and size fields, returning its length
+size_t buildPycHeader(const PycFormat& format, uint8_t* out);
+
+#endif // PYCHEADER_H
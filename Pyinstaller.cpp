@@ -1,304 +1,1452 @@
-#include <iostream>
-#include <fstream>
-#include <vector>
-#include <string>
-#include <cstring>
-#include "PyInstArchive.h"
-#include <winsock2.h>
-#include <random>
-#include <sstream>
-
-#pragma comment(lib, "ws2_32.lib")
-#pragma comment(lib, "oleaut32.lib")
-
-/**
- * @brief The magic string used to identify PyInstaller archives.
- *
- * This constant represents a specific sequence of bytes (`MEI\014\013\012\013\016`)
- * that is used by PyInstaller to mark the beginning of the archive's metadata.
- * The program uses this to verify if a file is a valid PyInstaller-generated archive.
- */
-const std::string PyInstArchive::MAGIC = "MEI\014\013\012\013\016";
-
-PyInstArchive::PyInstArchive(const std::string& path) : filePath(path), fileSize(0), cookiePos(-1) {}
-
-/**
- * @brief Opens the PyInstaller archive file for reading.
- *
- * This method attempts to open the file at the provided `filePath` in binary mode.
- * It also checks if the file is successfully opened and calculates its size.
- *
- * @return true if the file was successfully opened, false otherwise.
- */
-bool PyInstArchive::open() {
-    fPtr.open(filePath, std::ios::binary);
-    if (!fPtr.is_open()) {
-        std::cerr << "[!] Error: Could not open " << filePath << std::endl;
-        return false;
-    }
-    fPtr.seekg(0, std::ios::end);
-    fileSize = fPtr.tellg();
-    fPtr.seekg(0, std::ios::beg);
-    return true;
-}
-
-/**
- * @brief Closes the file stream if it is open.
- *
- * This method ensures that the file stream associated with the PyInstaller archive
- * is properly closed when it is no longer needed. It prevents resource leaks by
- * releasing the file handle.
- */
-void PyInstArchive::close() {
-    if (fPtr.is_open()) {
-        fPtr.close();
-    }
-}
-
-/**
- * @brief Checks if the file is a valid PyInstaller archive.
- *
- * This method searches for the magic string (a unique identifier) in the PyInstaller archive
- * and determines the version of PyInstaller used. If the magic string is found, it sets the
- * cookie position and identifies the PyInstaller version.
- *
- * @return true if the file is a valid PyInstaller archive, false otherwise.
- */
-bool PyInstArchive::checkFile() {
-    std::cout << "[+] Processing " << filePath << std::endl;
-    const size_t searchChunkSize = 8192;
-    uint64_t endPos = fileSize;
-    cookiePos = -1;
-
-    if (endPos < MAGIC.size()) {
-        std::cerr << "[!] Error: File is too short or truncated" << std::endl;
-        return false;
-    }
-
-    while (true) {
-        uint64_t startPos = endPos >= searchChunkSize ? endPos - searchChunkSize : 0;
-        size_t chunkSize = endPos - startPos;
-        if (chunkSize < MAGIC.size()) {
-            break;
-        }
-        fPtr.seekg(startPos, std::ios::beg);
-        std::vector<char> data(chunkSize);
-        fPtr.read(data.data(), chunkSize);
-
-        auto offs = std::string(data.data(), chunkSize).rfind(MAGIC);
-        if (offs != std::string::npos) {
-            cookiePos = startPos + offs;
-            break;
-        }
-        endPos = startPos + MAGIC.size() - 1;
-        if (startPos == 0) {
-            break;
-        }
-    }
-
-    if (cookiePos == -1) {
-        std::cerr << "[!] Error: Missing cookie, unsupported pyinstaller version or not a pyinstaller archive" << std::endl;
-        return false;
-    }
-
-    fPtr.seekg(cookiePos + PYINST20_COOKIE_SIZE, std::ios::beg);
-    std::vector<char> buffer(64);
-    fPtr.read(buffer.data(), 64);
-    if (std::string(buffer.data(), 64).find("python") != std::string::npos) {
-        std::cout << "[+] Pyinstaller version: 2.1+" << std::endl;
-        pyinstVer = 21;
-    }
-    else {
-        pyinstVer = 20;
-        std::cout << "[+] Pyinstaller version: 2.0" << std::endl;
-    }
-
-    return true;
-}
-
-/**
- * @brief Swaps the byte order of a 32-bit integer to correct endianness.
- *
- * This function is used to convert multi-byte integers between different
- * byte orders (big-endian to little-endian or vice versa).
- *
- * @param value The 32-bit integer whose bytes need to be swapped.
- * @return The integer with swapped byte order.
- */
-uint32_t swapBytes(uint32_t value) {
-    return ((value >> 24) & 0x000000FF) |
-        ((value >> 8) & 0x0000FF00) |
-        ((value << 8) & 0x00FF0000) |
-        ((value << 24) & 0xFF000000);
-}
-
-/**
- * @brief Extracts and parses CArchive information from the PyInstaller file.
- *
- * This function reads the package length, table of contents (TOC), and Python version
- * from the PyInstaller archive. It adjusts byte order for multi-byte values based on
- * the endianness and calculates offsets for further extraction.
- *
- * @return true if the archive information was successfully parsed, false if an error occurred.
- */
-bool PyInstArchive::getCArchiveInfo() {
-    try {
-        uint32_t lengthofPackage, toc, tocLen, pyver;
-
-        if (pyinstVer == 20) {
-            fPtr.seekg(cookiePos, std::ios::beg);
-            char buffer[PYINST20_COOKIE_SIZE];
-            fPtr.read(buffer, PYINST20_COOKIE_SIZE);
-            std::memcpy(&lengthofPackage, buffer + 8, 4);
-            std::memcpy(&toc, buffer + 12, 4);
-            std::memcpy(&tocLen, buffer + 16, 4);
-            std::memcpy(&pyver, buffer + 20, 4);
-        }
-        else if (pyinstVer == 21) {
-            fPtr.seekg(cookiePos, std::ios::beg);
-            char buffer[PYINST21_COOKIE_SIZE];
-            fPtr.read(buffer, PYINST21_COOKIE_SIZE);
-            std::memcpy(&lengthofPackage, buffer + 8, 4);
-            std::memcpy(&toc, buffer + 12, 4);
-            std::memcpy(&tocLen, buffer + 16, 4);
-            std::memcpy(&pyver, buffer + 20, 4);
-        }
-
-        // Convert values to host byte order (correcting endianness)
-        lengthofPackage = swapBytes(lengthofPackage);
-        toc = swapBytes(toc);
-        tocLen = swapBytes(tocLen);
-        pyver = swapBytes(pyver);
-
-        if (pyver >= 100) {
-            pymaj = pyver / 100;
-            pymin = pyver % 100;
-        }
-        else {
-            pymaj = pyver / 10;
-            pymin = pyver % 10;
-        }
-
-        std::cout << "[+] Python version: " << static_cast<int>(pymaj) << "." << static_cast<int>(pymin) << std::endl;
-
-        uint64_t tailBytes = fileSize - cookiePos - (pyinstVer == 20 ? PYINST20_COOKIE_SIZE : PYINST21_COOKIE_SIZE);
-        overlaySize = static_cast<uint64_t>(lengthofPackage) + tailBytes;
-        overlayPos = fileSize - overlaySize;
-        tableOfContentsPos = overlayPos + toc;
-        tableOfContentsSize = tocLen;
-
-        std::cout << "[+] Length of package: " << lengthofPackage << " bytes" << std::endl;
-        std::cout << "[DEBUG] overlaySize: " << overlaySize << std::endl;
-        std::cout << "[DEBUG] overlayPos: " << overlayPos << std::endl;
-        std::cout << "[DEBUG] tableOfContentsPos: " << tableOfContentsPos << std::endl;
-        std::cout << "[DEBUG] tableOfContentsSize: " << tableOfContentsSize << std::endl;
-
-        parseTOC();
-
-        std::cout << "[INFO] Entry sizes in the CArchive:" << std::endl;
-        for (const auto& entry : tocList) {
-            std::cout << "[INFO] Entry Name: " << entry.getName()
-                << ", Compressed Size: " << entry.getCompressedDataSize() << " bytes"
-                << std::endl;
-        }
-    }
-    catch (...) {
-        std::cerr << "[!] Error: The file is not a PyInstaller archive" << std::endl;
-        return false;
-    }
-    return true;
-}
-
-/**
- * @brief Parses the Table of Contents (TOC) from the PyInstaller archive.
- *
- * This function reads the TOC from the archive, which contains information about the
- * embedded files, such as their size, position in the archive, compression status, and type.
- * Each entry is stored in a list for further processing.
- */
-void PyInstArchive::parseTOC() {
-   
-    // Set the file pointer to the position of the Table of Contents
-    fPtr.seekg(tableOfContentsPos, std::ios::beg);
-
-    tocList.clear();  // Clear any existing TOC entries
-    uint32_t parsedLen = 0;  // Initialize parsed length
-
-    // Continue parsing until the total size of the TOC is reached
-    while (parsedLen < tableOfContentsSize) {
-        uint32_t entrySize;
-        fPtr.read(reinterpret_cast<char*>(&entrySize), sizeof(entrySize));  // Read the entry size
-        entrySize = swapBytes(entrySize);  // Convert entry size to host byte order
-
-        // Debugging output for entry size
-        std::cout << "[DEBUG] Entry Size: " << entrySize << ", Parsed Length: " << parsedLen << std::endl;
-
-        // Calculate the length of the name and allocate buffer
-        uint32_t nameLen = sizeof(uint32_t) + sizeof(uint32_t) * 3 + sizeof(uint8_t) + sizeof(char);
-        std::vector<char> nameBuffer(entrySize - nameLen);  // Create buffer for the name
-
-        // Variables to hold entry information
-        uint32_t entryPos, cmprsdDataSize, uncmprsdDataSize;
-        uint8_t cmprsFlag;
-        char typeCmprsData;
-
-        // Read the other fields from the file
-        fPtr.read(reinterpret_cast<char*>(&entryPos), sizeof(entryPos));
-        fPtr.read(reinterpret_cast<char*>(&cmprsdDataSize), sizeof(cmprsdDataSize));
-        fPtr.read(reinterpret_cast<char*>(&uncmprsdDataSize), sizeof(uncmprsdDataSize));
-        fPtr.read(reinterpret_cast<char*>(&cmprsFlag), sizeof(cmprsFlag));
-        fPtr.read(reinterpret_cast<char*>(&typeCmprsData), sizeof(typeCmprsData));
-        fPtr.read(nameBuffer.data(), entrySize - nameLen);
-
-        // Debugging output for each field read
-        std::cout << "[DEBUG] Entry Position: " << swapBytes(entryPos) << std::endl;
-        std::cout << "[DEBUG] Compressed Data Size: " << swapBytes(cmprsdDataSize) << std::endl;
-        std::cout << "[DEBUG] Uncompressed Data Size: " << swapBytes(uncmprsdDataSize) << std::endl;
-        std::cout << "[DEBUG] Compression Flag: " << static_cast<int>(cmprsFlag) << std::endl;
-        std::cout << "[DEBUG] Type of Compressed Data: " << typeCmprsData << std::endl;
-
-        // Decode the name from the buffer and remove null characters
-        std::string name(nameBuffer.data(), nameBuffer.size());
-        name.erase(std::remove(name.begin(), name.end(), '\0'), name.end());
-
-        // Debugging output for the name
-        std::cout << "[DEBUG] Name: '" << name << "'" << std::endl;
-
-        // Handle invalid names and normalize
-        if (name.empty() || name[0] == '/') {
-            name = "unnamed_" + std::to_string(parsedLen);
-            std::cout << "[DEBUG] Normalized Name: '" << name << "'" << std::endl;  // Debugging normalized name
-        }
-
-        // Add the entry to the TOC list
-        tocList.emplace_back(
-            overlayPos + swapBytes(entryPos),
-            swapBytes(cmprsdDataSize),
-            swapBytes(uncmprsdDataSize),
-            cmprsFlag,
-            typeCmprsData,
-            name
-        );
-
-        // Update the parsed length by the size of the current entry
-        parsedLen += entrySize;
-    }
-
-    // Output the total number of entries found in the TOC
-    std::cout << "[+] Found " << tocList.size() << " files in CArchive" << std::endl;
-
-}
-
-/**
- * @brief Displays the list of files in the PyInstaller archive.
- *
- * This method iterates over the Table of Contents (TOC) and prints the names
- * and uncompressed sizes of the embedded files.
- */
-void PyInstArchive::viewFiles() {
-    std::cout << "[+] Viewing files in the archive..." << std::endl;
-    for (const auto& entry : tocList) {
-        std::cout << entry.name << " (" << entry.uncmprsdDataSize << " bytes)" << std::endl;
-    }
-    std::cout << "[+] Finished viewing files." << std::endl;
-}
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <string>
+#include <cstring>
+#include "PyInstArchive.h"
+#include "MagicScanner.h"
+#include "ExecutableFormat.h"
+#include "Logger.h"
+#include <winsock2.h>
+#include <random>
+#include <sstream>
+#include <algorithm>
+#include <stdexcept>
+#include <atomic>
+#include <chrono>
+#include "ThreadPool.h"
+#include "OutputSink.h"
+#include "PycHeader.h"
+#include "PyzArchive.h"
+#include "MarshalReader.h"
+#include "Sha256.h"
+
+#pragma comment(lib, "ws2_32.lib")
+#pragma comment(lib, "oleaut32.lib")
+
+/**
+ * @brief The magic string used to identify PyInstaller archives.
+ *
+ * This constant represents a specific sequence of bytes (`MEI\014\013\012\013\016`)
+ * that is used by PyInstaller to mark the beginning of the archive's metadata.
+ * The program uses this to verify if a file is a valid PyInstaller-generated archive.
+ */
+const std::string PyInstArchive::MAGIC = "MEI\014\013\012\013\016";
+
+PyInstArchive::PyInstArchive(const std::string& path, bool useMmap)
+    : filePath(path), useMmap(useMmap), inMemory(false), fileData(nullptr), tailPrefetchSize(DEFAULT_TAIL_PREFETCH_SIZE),
+      tailPos(0), fileSize(0), cookiePos(-1), overlayPos(0), overlaySize(0), tableOfContentsPos(0),
+      tableOfContentsSize(0), pyinstVer(0), pymaj(0), pymin(0), lengthofPackage(0), toc(0), tocLen(0) {}
+
+/**
+ * @brief Creates an archive over bytes that are already in memory.
+ *
+ * Used for archives nested inside another one. No file is opened; open() and
+ * close() do nothing and every read is served from the buffer.
+ *
+ * @param data Start of the archive bytes, which must stay valid while the archive is used.
+ * @param size Number of bytes.
+ * @param name Name used in log messages.
+ * @param dataOwner Optional owner of the bytes, kept alive as long as the archive.
+ */
+PyInstArchive::PyInstArchive(const uint8_t* data, size_t size, const std::string& name, std::shared_ptr<const void> dataOwner)
+    : PyInstArchive(name, false) {
+    this->dataOwner = std::move(dataOwner);
+    inMemory = true;
+    fileData = data;
+    fileSize = size;
+}
+
+/**
+ * @brief Creates an archive that owns its bytes in memory.
+ *
+ * @param buffer The archive bytes.
+ * @param name Name used in log messages.
+ */
+PyInstArchive::PyInstArchive(std::vector<uint8_t>&& buffer, const std::string& name)
+    : PyInstArchive(name, false) {
+    ownedData = std::move(buffer);
+    inMemory = true;
+    fileData = ownedData.data();
+    fileSize = ownedData.size();
+}
+
+/**
+ * @brief Sets how many bytes are read from the end of the file when it is opened.
+ *
+ * In stream mode the cookie, the CArchive header and, for typical archives,
+ * the whole Table of Contents live in the last few hundred KB of the file.
+ * Reading that tail with one large read on open() lets checkFile(),
+ * getCArchiveInfo() and parseTOC() resolve everything from memory, which turns
+ * many small seeks into a single round trip on network-backed storage.
+ * Reads outside the prefetched window still go to the file. Memory-mapped
+ * archives ignore this setting. Must be called before open().
+ *
+ * @param bytes Size of the tail window, or 0 to disable prefetching.
+ */
+void PyInstArchive::setTailPrefetchSize(size_t bytes) {
+    tailPrefetchSize = bytes;
+}
+
+/**
+ * @brief Opens the PyInstaller archive file for reading.
+ *
+ * When memory mapping is enabled the whole file is mapped read-only, so that
+ * all later reads become pointer arithmetic over the mapped view. If mapping
+ * is disabled or fails, the file is opened as a binary stream instead.
+ * It also checks if the file is successfully opened and calculates its size.
+ *
+ * @return true if the file was successfully opened, false otherwise.
+ */
+bool PyInstArchive::open() {
+    if (inMemory) {
+        return true;
+    }
+    if (useMmap && mappedFile.open(filePath) && mappedFile.map()) {
+        fileData = mappedFile.data();
+        fileSize = mappedFile.size();
+        return true;
+    }
+
+    // Keep an unmapped native handle for kernel-side copies during extraction
+    if (!mappedFile.isOpen()) {
+        mappedFile.open(filePath);
+    }
+
+    fPtr.open(filePath, std::ios::binary);
+    if (!fPtr.is_open()) {
+        logError("Could not open ", filePath);
+        return false;
+    }
+    fPtr.seekg(0, std::ios::end);
+    fileSize = fPtr.tellg();
+    fPtr.seekg(0, std::ios::beg);
+
+    // Fetch the tail holding the cookie and usually the TOC in a single read
+    tailBuffer.clear();
+    tailPos = fileSize;
+    if (tailPrefetchSize > 0 && fileSize > 0) {
+        uint64_t tailLen = std::min<uint64_t>(fileSize, tailPrefetchSize);
+        std::vector<uint8_t> tail(static_cast<size_t>(tailLen));
+        if (readAt(fileSize - tailLen, tail.data(), tail.size())) {
+            tailBuffer.swap(tail);
+            tailPos = fileSize - tailLen;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Closes the file stream if it is open.
+ *
+ * This method ensures that the file stream associated with the PyInstaller archive
+ * is properly closed when it is no longer needed. It prevents resource leaks by
+ * releasing the file handle. Archives held in memory are left untouched.
+ */
+void PyInstArchive::close() {
+    if (inMemory) {
+        return;
+    }
+    if (fPtr.is_open()) {
+        fPtr.close();
+    }
+    mappedFile.close();
+    fileData = nullptr;
+    tailBuffer.clear();
+    tailPos = fileSize;
+}
+
+/**
+ * @brief Reads a byte range of the archive into a caller-provided buffer.
+ *
+ * Copies straight out of the mapped view or the prefetched tail when the range
+ * is resident in memory, otherwise falls back to a seek and read on the file stream.
+ * Safe to call from several extraction threads at once.
+ *
+ * @param offset Absolute file offset to start reading from.
+ * @param dst Destination buffer of at least `len` bytes.
+ * @param len Number of bytes to read.
+ * @return true if exactly `len` bytes were read, false otherwise.
+ */
+bool PyInstArchive::readAt(uint64_t offset, void* dst, size_t len) {
+    if (offset > fileSize || len > fileSize - offset) {
+        return false;
+    }
+    const uint8_t* view = viewAt(offset, len);
+    if (view != nullptr) {
+        std::memcpy(dst, view, len);
+        return true;
+    }
+    std::lock_guard<std::mutex> lock(streamMutex);
+    fPtr.clear();
+    fPtr.seekg(offset, std::ios::beg);
+    fPtr.read(static_cast<char*>(dst), len);
+    return static_cast<size_t>(fPtr.gcount()) == len;
+}
+
+/**
+ * @brief Returns a pointer to a byte range of the archive if it is resident in memory.
+ *
+ * @param offset Absolute file offset of the range.
+ * @param len Length of the range.
+ * @return Pointer into the mapped view or the prefetched tail, or nullptr if the
+ *         range has to be read from the file.
+ */
+const uint8_t* PyInstArchive::viewAt(uint64_t offset, uint64_t len) const {
+    if (offset > fileSize || len > fileSize - offset) {
+        return nullptr;
+    }
+    if (fileData != nullptr) {
+        return fileData + offset;
+    }
+    if (!tailBuffer.empty() && offset >= tailPos) {
+        return tailBuffer.data() + (offset - tailPos);
+    }
+    return nullptr;
+}
+
+/**
+ * @brief Returns a zero-copy view of the raw (possibly compressed) entry bytes.
+ *
+ * The pointer stays valid until close() is called.
+ *
+ * @param entry A TOC entry of this archive.
+ * @return Pointer to `entry.cmprsdDataSize` bytes, or nullptr if the archive is not
+ *         memory-mapped or the entry lies outside the file.
+ */
+const uint8_t* PyInstArchive::getEntryData(const CTOCEntry& entry) const {
+    if (fileData == nullptr || entry.position > fileSize || entry.cmprsdDataSize > fileSize - entry.position) {
+        return nullptr;
+    }
+    return fileData + entry.position;
+}
+
+/**
+ * @brief Returns a zero-copy view of the raw entry bytes of a TOC row.
+ *
+ * @param entry A row of getTOC().
+ * @return Pointer to the compressed entry bytes, or nullptr if unavailable.
+ */
+const uint8_t* PyInstArchive::getEntryData(const TocTable::Entry& entry) const {
+    uint64_t position = entry.getPosition();
+    if (fileData == nullptr || position > fileSize || entry.getCompressedDataSize() > fileSize - position) {
+        return nullptr;
+    }
+    return fileData + position;
+}
+
+/**
+ * @brief Looks up a single TOC entry by name.
+ *
+ * Uses the hashed name index built while parsing the TOC, so the lookup cost
+ * does not depend on the number of entries. Requires getCArchiveInfo() or
+ * parseTOC() to have run.
+ *
+ * @param name Exact name of the entry, as listed by viewFiles().
+ * @return The entry, or std::nullopt if the archive has no entry with that name.
+ */
+std::optional<TocTable::Entry> PyInstArchive::findEntry(std::string_view name) const {
+    size_t row = tocList.find(name);
+    if (row == TocTable::npos) {
+        return std::nullopt;
+    }
+    return tocList[row];
+}
+
+/**
+ * @brief Checks if the file is a valid PyInstaller archive.
+ *
+ * This method searches backwards from the end of the file for the magic string (a unique
+ * identifier) using the vectorized scanner in MagicScanner.cpp, working directly on the
+ * mapped view or on reused read buffers, and determines the version of PyInstaller used. If the magic string is found, it sets the
+ * cookie position and identifies the PyInstaller version.
+ *
+ * For PE, ELF and Mach-O files the search is limited to the region that
+ * locateArchiveRegion() derives from the section and segment tables, so
+ * the code and data of large executables without an archive are never read.
+ * Other files, and executables with malformed headers, are searched whole.
+ *
+ * @return true if the file is a valid PyInstaller archive, false otherwise.
+ */
+bool PyInstArchive::checkFile() {
+    logInfo("Processing ", filePath);
+    const size_t searchChunkSize = 8192;
+    cookiePos = -1;
+
+    if (fileSize < MAGIC.size()) {
+        logError("File is too short or truncated");
+        return false;
+    }
+
+    uint64_t searchStart = 0;
+    uint64_t searchEnd = fileSize;
+    uint8_t head[EXECUTABLE_HEADER_PROBE_SIZE];
+    size_t headLen = static_cast<size_t>(std::min<uint64_t>(fileSize, sizeof(head)));
+    if (readAt(0, head, headLen)) {
+        ExecutableFormat format = detectExecutableFormat(head, headLen);
+        FileReader reader = [this](uint64_t offset, void* dst, size_t len) {
+            return readAt(offset, dst, len);
+        };
+        if (format != ExecutableFormat::Unknown && locateArchiveRegion(format, fileSize, reader, searchStart, searchEnd) &&
+            searchStart <= searchEnd && searchEnd <= fileSize) {
+            logDebug(executableFormatName(format), " archive region: ", searchStart, "-", searchEnd);
+        }
+        else {
+            searchStart = 0;
+            searchEnd = fileSize;
+        }
+    }
+    uint64_t endPos = searchEnd;
+
+    if (searchEnd - searchStart < MAGIC.size()) {
+        logDebug("Nothing follows the executable's sections");
+    }
+    else if (fileData != nullptr) {
+        // The whole file is mapped, scan the region backwards in place in a single pass
+        const uint8_t* found = findLastMagic(fileData + searchStart, static_cast<size_t>(searchEnd - searchStart));
+        if (found != nullptr) {
+            cookiePos = found - fileData;
+        }
+    }
+    else {
+        // Search the prefetched tail first, then continue backwards from the file
+        bool scanned = false;
+        if (!tailBuffer.empty() && tailPos < searchEnd) {
+            uint64_t from = std::max(tailPos, searchStart);
+            const uint8_t* begin = tailBuffer.data() + (from - tailPos);
+            const uint8_t* found = findLastMagic(begin, static_cast<size_t>(searchEnd - from));
+            if (found != nullptr) {
+                cookiePos = from + (found - begin);
+            }
+            else if (from > searchStart) {
+                endPos = std::min<uint64_t>(searchEnd, from + MAGIC.size() - 1);
+            }
+            scanned = found != nullptr || from == searchStart;
+        }
+
+        std::vector<uint8_t> data(searchChunkSize);
+        while (!scanned) {
+            uint64_t startPos = endPos - searchStart >= searchChunkSize ? endPos - searchChunkSize : searchStart;
+            size_t chunkSize = endPos - startPos;
+            if (chunkSize < MAGIC.size() || !readAt(startPos, data.data(), chunkSize)) {
+                break;
+            }
+
+            const uint8_t* found = findLastMagic(data.data(), chunkSize);
+            if (found != nullptr) {
+                cookiePos = startPos + (found - data.data());
+                break;
+            }
+            endPos = startPos + MAGIC.size() - 1;
+            if (startPos == searchStart) {
+                break;
+            }
+        }
+    }
+
+    if (cookiePos == -1) {
+        logError("Missing cookie, unsupported pyinstaller version or not a pyinstaller archive");
+        return false;
+    }
+
+    char buffer[64] = {};
+    readAt(cookiePos + PYINST20_COOKIE_SIZE, buffer, sizeof(buffer));
+    if (std::string(buffer, sizeof(buffer)).find("python") != std::string::npos) {
+        logInfo("Pyinstaller version: 2.1+");
+        pyinstVer = 21;
+    }
+    else {
+        pyinstVer = 20;
+        logInfo("Pyinstaller version: 2.0");
+    }
+
+    return true;
+}
+
+/**
+ * @brief Swaps the byte order of a 32-bit integer to correct endianness.
+ *
+ * This function is used to convert multi-byte integers between different
+ * byte orders (big-endian to little-endian or vice versa).
+ *
+ * @param value The 32-bit integer whose bytes need to be swapped.
+ * @return The integer with swapped byte order.
+ */
+uint32_t swapBytes(uint32_t value) {
+    return ((value >> 24) & 0x000000FF) |
+        ((value >> 8) & 0x0000FF00) |
+        ((value << 8) & 0x00FF0000) |
+        ((value << 24) & 0xFF000000);
+}
+
+/**
+ * @brief Extracts and parses CArchive information from the PyInstaller file.
+ *
+ * This function reads the package length, table of contents (TOC), and Python version
+ * from the PyInstaller archive. It adjusts byte order for multi-byte values based on
+ * the endianness and calculates offsets for further extraction.
+ *
+ * @return true if the archive information was successfully parsed, false if an error occurred.
+ */
+bool PyInstArchive::getCArchiveInfo() {
+    try {
+        uint32_t pyver;
+
+        if (pyinstVer == 20) {
+            char buffer[PYINST20_COOKIE_SIZE];
+            if (!readAt(cookiePos, buffer, PYINST20_COOKIE_SIZE)) {
+                throw std::runtime_error("truncated cookie");
+            }
+            std::memcpy(&lengthofPackage, buffer + 8, 4);
+            std::memcpy(&toc, buffer + 12, 4);
+            std::memcpy(&tocLen, buffer + 16, 4);
+            std::memcpy(&pyver, buffer + 20, 4);
+        }
+        else if (pyinstVer == 21) {
+            char buffer[PYINST21_COOKIE_SIZE];
+            if (!readAt(cookiePos, buffer, PYINST21_COOKIE_SIZE)) {
+                throw std::runtime_error("truncated cookie");
+            }
+            std::memcpy(&lengthofPackage, buffer + 8, 4);
+            std::memcpy(&toc, buffer + 12, 4);
+            std::memcpy(&tocLen, buffer + 16, 4);
+            std::memcpy(&pyver, buffer + 20, 4);
+        }
+
+        // Convert values to host byte order (correcting endianness)
+        lengthofPackage = swapBytes(lengthofPackage);
+        toc = swapBytes(toc);
+        tocLen = swapBytes(tocLen);
+        pyver = swapBytes(pyver);
+
+        if (pyver >= 100) {
+            pymaj = pyver / 100;
+            pymin = pyver % 100;
+        }
+        else {
+            pymaj = pyver / 10;
+            pymin = pyver % 10;
+        }
+
+        logInfo("Python version: ", static_cast<int>(pymaj), ".", static_cast<int>(pymin));
+
+        // The cookie fields are untrusted: the package, and the TOC inside it, must lie within the file
+        uint64_t tailBytes = fileSize - cookiePos - (pyinstVer == 20 ? PYINST20_COOKIE_SIZE : PYINST21_COOKIE_SIZE);
+        overlaySize = static_cast<uint64_t>(lengthofPackage) + tailBytes;
+        if (overlaySize > fileSize || toc > overlaySize || tocLen > overlaySize - toc) {
+            throw std::runtime_error("package or table of contents outside the file");
+        }
+        overlayPos = fileSize - overlaySize;
+        tableOfContentsPos = overlayPos + toc;
+        tableOfContentsSize = tocLen;
+
+        logInfo("Length of package: ", lengthofPackage, " bytes");
+        logDebug("overlaySize: ", overlaySize);
+        logDebug("overlayPos: ", overlayPos);
+        logDebug("tableOfContentsPos: ", tableOfContentsPos);
+        logDebug("tableOfContentsSize: ", tableOfContentsSize);
+
+        parseTOC();
+
+        if constexpr (COMPILED_LOG_LEVEL >= LogLevel::Debug) {
+            logDebug("Entry sizes in the CArchive:");
+            for (const auto& entry : tocList) {
+                logDebug("Entry Name: ", entry.getName(), ", Compressed Size: ", entry.getCompressedDataSize(), " bytes");
+            }
+        }
+    }
+    catch (...) {
+        logError("The file is not a PyInstaller archive");
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads a big-endian 32-bit integer from an unaligned buffer.
+ *
+ * @param p Pointer to at least four readable bytes.
+ * @return The decoded integer in host byte order.
+ */
+static uint32_t readUInt32BE(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) |
+        (static_cast<uint32_t>(p[1]) << 16) |
+        (static_cast<uint32_t>(p[2]) << 8) |
+        static_cast<uint32_t>(p[3]);
+}
+
+/**
+ * @brief Parses the Table of Contents (TOC) from the PyInstaller archive.
+ *
+ * This function fetches the whole TOC block at once, which is free when the archive
+ * is memory-mapped or the TOC lies in the prefetched tail and a single read otherwise,
+ * and then decodes the entries from memory. Each entry contains information about an
+ * embedded file, such as its size, position in the archive, compression status, and type,
+ * and is stored column-wise in the TOC table for further processing.
+ *
+ * @throws std::runtime_error if the TOC lies outside the file, is truncated or an entry size is malformed.
+ */
+void PyInstArchive::parseTOC() {
+    if (tableOfContentsPos > fileSize || tableOfContentsSize > fileSize - tableOfContentsPos) {
+        throw std::runtime_error("table of contents outside the file");
+    }
+
+    // Get the whole Table of Contents into memory
+    const uint8_t* tocData = viewAt(tableOfContentsPos, tableOfContentsSize);
+    std::vector<uint8_t> tocBuffer;
+    if (tocData == nullptr) {
+        tocBuffer.resize(static_cast<size_t>(tableOfContentsSize));
+        if (!readAt(tableOfContentsPos, tocBuffer.data(), tocBuffer.size())) {
+            throw std::runtime_error("truncated table of contents");
+        }
+        tocData = tocBuffer.data();
+    }
+
+    // Size of the fixed fields preceding the name in each entry
+    const uint32_t entryHeaderSize = sizeof(uint32_t) + sizeof(uint32_t) * 3 + sizeof(uint8_t) + sizeof(char);
+
+    tocList.clear();  // Clear any existing TOC entries
+    tocList.reserve(static_cast<size_t>(tableOfContentsSize / (entryHeaderSize + 8)), static_cast<size_t>(tableOfContentsSize));
+    uint32_t parsedLen = 0;  // Initialize parsed length
+
+    // Continue parsing until the total size of the TOC is reached
+    while (parsedLen < tableOfContentsSize) {
+        if (tableOfContentsSize - parsedLen < entryHeaderSize) {
+            throw std::runtime_error("truncated table of contents entry");
+        }
+        const uint8_t* entry = tocData + parsedLen;
+        uint32_t entrySize = readUInt32BE(entry);
+
+        // Debugging output for entry size
+        logDebug("Entry Size: ", entrySize, ", Parsed Length: ", parsedLen);
+
+        if (entrySize < entryHeaderSize || entrySize > tableOfContentsSize - parsedLen) {
+            throw std::runtime_error("invalid table of contents entry size");
+        }
+
+        // Decode the fixed fields
+        uint32_t entryPos = readUInt32BE(entry + 4);
+        uint32_t cmprsdDataSize = readUInt32BE(entry + 8);
+        uint32_t uncmprsdDataSize = readUInt32BE(entry + 12);
+        uint8_t cmprsFlag = entry[16];
+        char typeCmprsData = static_cast<char>(entry[17]);
+
+        // Debugging output for each field read
+        logDebug("Entry Position: ", entryPos);
+        logDebug("Compressed Data Size: ", cmprsdDataSize);
+        logDebug("Uncompressed Data Size: ", uncmprsdDataSize);
+        logDebug("Compression Flag: ", static_cast<int>(cmprsFlag));
+        logDebug("Type of Compressed Data: ", typeCmprsData);
+
+        // Decode the name, which is padded with null characters up to the entry size
+        const char* nameData = reinterpret_cast<const char*>(entry + entryHeaderSize);
+        size_t nameSize = entrySize - entryHeaderSize;
+        const void* nul = std::memchr(nameData, '\0', nameSize);
+        std::string_view name(nameData, nul != nullptr ? static_cast<const char*>(nul) - nameData : nameSize);
+
+        // Debugging output for the name
+        logDebug("Name: '", name, "'");
+
+        // Handle invalid names and normalize
+        std::string normalizedName;
+        if (name.empty() || name[0] == '/') {
+            normalizedName = "unnamed_" + std::to_string(parsedLen);
+            name = normalizedName;
+            logDebug("Normalized Name: '", name, "'");  // Debugging normalized name
+        }
+
+        // Add the entry to the TOC list
+        tocList.add(
+            overlayPos + entryPos,
+            cmprsdDataSize,
+            uncmprsdDataSize,
+            cmprsFlag,
+            typeCmprsData,
+            name
+        );
+
+        // Update the parsed length by the size of the current entry
+        parsedLen += entrySize;
+    }
+
+    // Output the total number of entries found in the TOC
+    logInfo("Found ", tocList.size(), " files in CArchive");
+
+}
+
+/**
+ * @brief Returns the parsed CArchive metadata and entry table.
+ *
+ * Lets embedders consume the results of checkFile() and getCArchiveInfo()
+ * directly instead of scraping the console output. The returned entry table
+ * points into this archive and is valid until the TOC is parsed again or the
+ * archive is destroyed.
+ *
+ * @return The archive information; all fields are zero before getCArchiveInfo() succeeded.
+ */
+ArchiveInfo PyInstArchive::getArchiveInfo() const {
+    ArchiveInfo info;
+    info.filePath = filePath;
+    info.fileSize = fileSize;
+    info.pyinstVer = pyinstVer;
+    info.pymaj = pymaj;
+    info.pymin = pymin;
+    info.lengthofPackage = lengthofPackage;
+    info.cookiePos = cookiePos;
+    info.overlayPos = overlayPos;
+    info.overlaySize = overlaySize;
+    info.tableOfContentsPos = tableOfContentsPos;
+    info.tableOfContentsSize = tableOfContentsSize;
+    info.entries = &tocList;
+    return info;
+}
+
+/**
+ * @brief Calls the visitor once for every TOC entry, in archive order.
+ *
+ * @param visitor Receives each entry as a TocTable::Entry view.
+ */
+void PyInstArchive::visitEntries(TocVisitor& visitor) const {
+    for (const auto& entry : tocList) {
+        visitor.visit(entry);
+    }
+}
+
+/**
+ * @brief Displays the list of files in the PyInstaller archive.
+ *
+ * This method iterates over the Table of Contents (TOC) and prints the names
+ * and uncompressed sizes of the embedded files.
+ */
+void PyInstArchive::viewFiles() {
+    logInfo("Viewing files in the archive...");
+    for (const auto& entry : tocList) {
+        std::cout << entry.getName() << " (" << entry.getUncompressedDataSize() << " bytes)\n";
+    }
+    logInfo("Finished viewing files.");
+}
+
+/**
+ * @brief Provides the raw (possibly compressed) bytes of an entry.
+ *
+ * Returns a pointer into the mapped view or prefetched tail when possible and
+ * reads the entry into `buffer` otherwise.
+ *
+ * @param entry The TOC entry to load.
+ * @param buffer Scratch buffer used when the bytes are not resident in memory.
+ * @return Pointer to `entry.getCompressedDataSize()` bytes, or nullptr if the entry is out of bounds.
+ */
+const uint8_t* PyInstArchive::loadEntryData(const TocTable::Entry& entry, std::vector<uint8_t>& buffer) {
+    const uint8_t* data = viewAt(entry.getPosition(), entry.getCompressedDataSize());
+    if (data != nullptr) {
+        return data;
+    }
+    buffer.resize(entry.getCompressedDataSize());
+    if (!readAt(entry.getPosition(), buffer.data(), buffer.size())) {
+        return nullptr;
+    }
+    return buffer.data();
+}
+
+/**
+ * @brief Creates a source that reads a byte range of the archive in fixed-size chunks.
+ *
+ * Chunks resident in memory are returned in place; others are read into
+ * `buffer`, which is reused for every chunk and must outlive the source.
+ *
+ * @param offset Start of the range, usually the position of an entry.
+ * @param remaining Length of the range.
+ * @param chunkSize Maximum number of bytes per chunk.
+ * @param buffer Scratch buffer for chunks read from the file.
+ * @return A source yielding the bytes of the range and then an empty chunk.
+ */
+InflateSource PyInstArchive::rangeSource(uint64_t offset, uint64_t remaining, size_t chunkSize, std::vector<uint8_t>& buffer) {
+    return [this, offset, remaining, chunkSize, &buffer](const uint8_t*& data, size_t& len) mutable {
+        len = static_cast<size_t>(std::min<uint64_t>(remaining, chunkSize));
+        if (len == 0) {
+            data = nullptr;
+            return true;
+        }
+        data = viewAt(offset, len);
+        if (data == nullptr) {
+            buffer.resize(chunkSize);
+            if (!readAt(offset, buffer.data(), len)) {
+                return false;
+            }
+            data = buffer.data();
+        }
+        offset += len;
+        remaining -= len;
+        return true;
+    };
+}
+
+/**
+ * @brief Writes the decoded payload of an entry to a sink.
+ *
+ * Stored entries (compression flag 0) are byte-identical slices of the archive.
+ * With `options.kernelCopy` they are handed to the sink's kernel-side copy
+ * first (copy_file_range or sendfile from the archive handle), and whatever
+ * that cannot copy is written from the mapped view or in fixed-size chunks. Compressed
+ * entries (flag 1) up to `options.streamingThreshold` bytes are inflated in one
+ * call into a buffer of the size recorded in the TOC; larger ones are streamed
+ * through inflate in `options.streamChunkSize` pieces, so peak memory per worker
+ * stays constant regardless of the entry size.
+ *
+ * @param entry The TOC entry to decode.
+ * @param sink Destination of the payload.
+ * @param decompressor Inflate backend for compressed entries.
+ * @param options Streaming threshold and chunk size.
+ * @return true if the complete payload was written, false otherwise.
+ */
+bool PyInstArchive::writeEntryPayload(const TocTable::Entry& entry, OutputSink& sink, const Decompressor& decompressor, const ExtractOptions& options) {
+    const size_t chunkSize = std::max<size_t>(options.streamChunkSize, 4096);
+    std::vector<uint8_t> chunkBuffer;
+
+    if (entry.getCompressionFlag() == 0) {
+        uint64_t offset = entry.getPosition();
+        uint64_t remaining = entry.getCompressedDataSize();
+        if (offset > fileSize || remaining > fileSize - offset) {
+            logError("Entry ", entry.getName(), " lies outside the file");
+            return false;
+        }
+        if (options.kernelCopy) {
+            uint64_t copied = sink.copyFrom(mappedFile, offset, remaining);
+            offset += copied;
+            remaining -= copied;
+        }
+        const uint8_t* view = viewAt(offset, remaining);
+        if (view != nullptr) {
+            return sink.write(view, static_cast<size_t>(remaining));
+        }
+        InflateSource source = rangeSource(offset, remaining, chunkSize, chunkBuffer);
+        const uint8_t* data;
+        size_t len;
+        while (source(data, len)) {
+            if (len == 0) {
+                return true;
+            }
+            if (!sink.write(data, len)) {
+                return false;
+            }
+        }
+        logError("Entry ", entry.getName(), " lies outside the file");
+        return false;
+    }
+
+    if (entry.getCompressionFlag() != 1) {
+        logError("Unsupported compression flag ", static_cast<int>(entry.getCompressionFlag()), " for ", entry.getName());
+        return false;
+    }
+
+    if (entry.getUncompressedDataSize() <= options.streamingThreshold) {
+        std::vector<uint8_t> rawBuffer;
+        const uint8_t* raw = loadEntryData(entry, rawBuffer);
+        if (raw == nullptr) {
+            logError("Entry ", entry.getName(), " lies outside the file");
+            return false;
+        }
+        std::vector<uint8_t> inflated(entry.getUncompressedDataSize());
+        if (!decompressor.inflateBuffer(raw, entry.getCompressedDataSize(), inflated.data(), inflated.size())) {
+            logError("Failed to decompress ", entry.getName());
+            return false;
+        }
+        return sink.write(inflated.data(), inflated.size());
+    }
+
+    uint64_t written = 0;
+    bool sinkFailed = false;
+    bool inflatedOk = decompressor.inflateStream(
+        rangeSource(entry.getPosition(), entry.getCompressedDataSize(), chunkSize, chunkBuffer),
+        [&](const uint8_t* data, size_t len) {
+            written += len;
+            if (written > entry.getUncompressedDataSize() || !sink.write(data, len)) {
+                sinkFailed = true;
+                return false;
+            }
+            return true;
+        },
+        chunkSize);
+    if (!inflatedOk || written != entry.getUncompressedDataSize()) {
+        if (!sinkFailed) {
+            logError("Failed to decompress ", entry.getName());
+        }
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Summarizes the options that change the bytes of the outputs.
+ *
+ * Stored in incremental manifests, so that outputs written with other
+ * settings are not mistaken for current ones.
+ */
+std::string ExtractOptions::outputSettings() const {
+    return "pyc=" + std::to_string(pycHeaders) + " pyz=" + std::to_string(extractPyz) +
+        " depth=" + std::to_string(maxNestingDepth);
+}
+
+/**
+ * @brief Opens the destination of one output of the run.
+ *
+ * @param path Where the output belongs in the output tree.
+ * @return A file sink for `path`, or with a content store a sink that files
+ *         the output under its digest and records `path` in the manifest;
+ *         nullptr if the file could not be created.
+ */
+std::unique_ptr<OutputSink> ExtractionContext::openSink(const std::filesystem::path& path) {
+    if (store != nullptr) {
+        return std::make_unique<StoreSink>(*store, path.lexically_relative(outputRoot).generic_u8string());
+    }
+    auto sink = std::make_unique<FileSink>(path);
+    if (!sink->open()) {
+        return nullptr;
+    }
+    return sink;
+}
+
+/**
+ * @brief Returns the recorded hash of an entry that is known not to have changed.
+ *
+ * While the archive file is the one the manifest was written for, an entry
+ * with the name, position and size of its previous record has the same
+ * bytes, so re-runs of an unchanged archive read no entry data at all.
+ *
+ * @param path Output path.
+ * @param compressedSize Size of the raw entry bytes.
+ * @param position Offset of the entry in its archive.
+ * @return The hash of the previous record, or an empty string if the entry has to be hashed.
+ */
+std::string ExtractionContext::knownHash(const std::filesystem::path& path, uint64_t compressedSize, uint64_t position) const {
+    if (!sameSource) {
+        return std::string();
+    }
+    const ManifestEntry* previous = manifest->findPrevious(path.lexically_relative(outputRoot).generic_u8string());
+    if (previous == nullptr || previous->compressedSize != compressedSize || previous->position != position) {
+        return std::string();
+    }
+    return previous->hash;
+}
+
+/**
+ * @brief Checks whether an output of the previous run can be kept as it is.
+ *
+ * The output is unchanged if the previous run recorded the same raw size and
+ * hash for it and the file is still there with the recorded size. The raw
+ * bytes identify the output even when the entry moved in a new build. Outputs
+ * of an archive expanded from it must be intact as well, and all of them must
+ * still be recorded, otherwise the archive is expanded again and its intact
+ * outputs are skipped one by one. When it is unchanged, all these records are
+ * carried over into the new manifest.
+ *
+ * @param path Output path.
+ * @param compressedSize Size of the raw entry bytes.
+ * @param hash SHA-256 of the raw entry bytes.
+ * @param parent Pending record of the entry holding this output's archive, or nullptr.
+ * @return true if the output does not need to be written again.
+ */
+bool ExtractionContext::isUnchanged(const std::filesystem::path& path, uint64_t compressedSize, const std::string& hash, PendingRecord* parent) {
+    std::string name = path.lexically_relative(outputRoot).generic_u8string();
+    const ManifestEntry* previous = manifest->findPrevious(name);
+    if (previous == nullptr || previous->compressedSize != compressedSize || previous->hash != hash) {
+        return false;
+    }
+    auto intact = [&](const ManifestEntry& entry) {
+        std::error_code ec;
+        return std::filesystem::file_size(outputRoot / std::filesystem::u8path(entry.name), ec) == entry.outputSize && !ec;
+    };
+    std::vector<const ManifestEntry*> nested = manifest->findPreviousBelow(name + "_extracted/");
+    if (nested.size() != previous->children || !intact(*previous) ||
+        !std::all_of(nested.begin(), nested.end(), [&](const ManifestEntry* entry) { return intact(*entry); })) {
+        return false;
+    }
+    manifest->record(*previous);
+    for (const ManifestEntry* entry : nested) {
+        manifest->record(*entry);
+    }
+    if (parent != nullptr) {
+        parent->children += 1 + nested.size();
+    }
+    // The outputs of the archive are kept along with it and count as handled by this run
+    files += nested.size();
+    unchanged += 1 + nested.size();
+    return true;
+}
+
+/**
+ * @brief Prepares the manifest record of a freshly written output.
+ *
+ * The record is written when the returned pointer is released, or, if it
+ * is passed on as the parent of the outputs of an archive expanded from this
+ * one, once those are all recorded too. If any of them fails, neither this
+ * record nor those of the enclosing archives are written, so the next run
+ * expands the archive again instead of keeping it with outputs missing.
+ *
+ * @param path Output path.
+ * @param compressedSize Size of the raw entry bytes.
+ * @param position Offset of the entry in its archive.
+ * @param hash SHA-256 of the raw entry bytes, empty if it could not be computed.
+ * @param parent Pending record of the entry holding this output's archive, or nullptr.
+ * @return The pending record.
+ */
+std::shared_ptr<PendingRecord> ExtractionContext::recordOutput(const std::filesystem::path& path, uint64_t compressedSize, uint64_t position, const std::string& hash, const std::shared_ptr<PendingRecord>& parent) {
+    std::error_code ec;
+    uint64_t outputSize = std::filesystem::file_size(path, ec);
+    auto record = std::make_shared<PendingRecord>(*this,
+        ManifestEntry{ path.lexically_relative(outputRoot).generic_u8string(), compressedSize, position, outputSize, hash }, parent);
+    if (ec || hash.empty()) {
+        record->incomplete = true;
+    }
+    return record;
+}
+
+PendingRecord::PendingRecord(ExtractionContext& context, ManifestEntry entry, std::shared_ptr<PendingRecord> parent)
+    : context(context), entry(std::move(entry)), parent(std::move(parent)) {}
+
+/**
+ * @brief Writes the record unless an output below it is missing, and reports to the parent record.
+ */
+PendingRecord::~PendingRecord() {
+    if (incomplete) {
+        if (parent) {
+            parent->incomplete = true;
+        }
+        return;
+    }
+    entry.children = children;
+    if (parent) {
+        parent->children += 1 + entry.children;
+    }
+    context.manifest->record(std::move(entry));
+}
+
+/**
+ * @brief Runs one extraction into a directory.
+ *
+ * Shared by the CArchive and PYZ entry points: creates the inflate backend,
+ * the output directory and, as the options ask, the content store, the
+ * incremental manifest and the resume journal, then lets `schedule` submit
+ * the work to a new pool and waits for it. Afterwards the journal is closed,
+ * the manifests are written and the outcome is logged.
+ *
+ * @param outputDir Directory to extract into; created if missing.
+ * @param options Settings of the run.
+ * @param source Fingerprint of the archive file for the manifest, empty for archives in memory.
+ * @param schedule Submits the entries or modules to the pool of the context.
+ * @param stats Receives the statistics of the run; `schedule` may set `skipped`.
+ * @return true if everything was extracted and recorded, false otherwise.
+ */
+bool runExtraction(const std::filesystem::path& outputDir, const ExtractOptions& options, const std::string& source, const std::function<void(ExtractionContext&)>& schedule, ExtractionStats& stats) {
+    stats = ExtractionStats();
+    std::unique_ptr<Decompressor> decompressor = createDecompressor(options.inflateBackend);
+    if (!decompressor) {
+        logError("Requested inflate backend is not available in this build");
+        return false;
+    }
+    logDebug("Inflate backend: ", decompressor->name());
+
+    std::string outputName = outputDir.u8string();
+    std::error_code ec;
+    std::filesystem::create_directories(outputDir, ec);
+    if (ec) {
+        logError("Could not create ", outputName);
+        return false;
+    }
+
+    std::unique_ptr<ContentStore> store;
+    if (!options.contentStore.empty()) {
+        store = std::make_unique<ContentStore>(std::filesystem::u8path(options.contentStore));
+        if (!store->open()) {
+            logError("Could not create content store ", options.contentStore);
+            return false;
+        }
+    }
+
+    ExtractManifest manifest;
+    manifest.setSource(source);
+    bool incremental = options.incremental && !store;
+    bool resume = options.resume && !store;
+    if (incremental && !manifest.load(outputDir / EXTRACT_MANIFEST_NAME, options.outputSettings())) {
+        logDebug("No usable manifest in ", outputName, ", extracting everything");
+    }
+    if (resume && manifest.openJournal(outputDir / EXTRACT_JOURNAL_NAME, options.outputSettings())) {
+        logInfo("Resuming the interrupted extraction into ", outputName);
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    {
+        ThreadPool pool(options.threads);
+        ExtractionContext context{ pool, *decompressor, options };
+        context.store = store.get();
+        context.manifest = incremental || resume ? &manifest : nullptr;
+        context.outputRoot = outputDir;
+        context.sameSource = manifest.isSameSource();
+        schedule(context);
+        pool.wait();
+        stats.workers = pool.getWorkerStats();
+        stats.files = context.files;
+        stats.failures = context.failures;
+        stats.unchanged = context.unchanged;
+        stats.nestedArchives = context.nestedArchives;
+    }
+    stats.wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    for (size_t i = 0; i < stats.workers.size(); ++i) {
+        const WorkerStats& worker = stats.workers[i];
+        logDebug("Worker ", i, ": ", worker.tasks, " tasks (", worker.stolen, " stolen), ",
+            static_cast<int>(worker.utilization * 100), "% busy");
+    }
+    logInfo("Extracted ", stats.files - stats.failures - stats.unchanged, " of ", stats.files, " files to ", outputName);
+    if (stats.nestedArchives > 0) {
+        logInfo("Expanded ", stats.nestedArchives, " nested archives");
+    }
+    manifest.closeJournal(stats.failures == 0);
+    if (incremental) {
+        if (!manifest.save(outputDir / EXTRACT_MANIFEST_NAME, options.outputSettings())) {
+            logError("Could not write the manifest to ", outputName);
+            return false;
+        }
+        if (stats.unchanged > 0) {
+            logInfo("Kept ", stats.unchanged, " files unchanged since the last run");
+        }
+    }
+    else if (resume && stats.unchanged > 0) {
+        logInfo("Kept ", stats.unchanged, " files finished by the interrupted run");
+    }
+    if (store) {
+        if (!store->writeManifest(outputDir / STORE_MANIFEST_NAME)) {
+            logError("Could not write the manifest to ", outputName);
+            return false;
+        }
+        logInfo("Stored ", store->getObjectsWritten(), " new objects, reused ", store->getObjectsReused(),
+            " (", store->getBytesReused(), " bytes deduplicated)");
+    }
+    if (stats.skipped > 0) {
+        logInfo("Skipped ", stats.skipped, " files excluded by the filter");
+    }
+    return stats.failures == 0;
+}
+
+/**
+ * @brief Hashes the raw bytes of an entry as stored in the archive.
+ *
+ * The bytes are read in chunks, so large entries do not need to fit in memory.
+ *
+ * @param entry The TOC entry.
+ * @param chunkSize Bytes per read when the entry is not memory-resident.
+ * @return The lowercase hex SHA-256, or an empty string if the entry could not be read.
+ */
+std::string PyInstArchive::hashEntry(const TocTable::Entry& entry, size_t chunkSize) {
+    std::vector<uint8_t> buffer;
+    InflateSource source = rangeSource(entry.getPosition(), entry.getCompressedDataSize(), chunkSize, buffer);
+    Sha256 hash;
+    const uint8_t* data;
+    size_t len;
+    while (source(data, len)) {
+        if (len == 0) {
+            return hash.finishHex();
+        }
+        hash.update(data, len);
+    }
+    return std::string();
+}
+
+/**
+ * @brief Extracts a single entry into the output directory.
+ *
+ * Scripts (type 's') are stored as bare marshalled code objects. With
+ * `options.pycHeaders` they are written as `<name>.pyc`, with the pyc header of
+ * the archive's Python version written to the sink ahead of the payload, so
+ * the payload itself still goes through the usual zero-copy paths.
+ *
+ * With an incremental manifest, the raw entry bytes are hashed first, unless
+ * knownHash() can vouch for them, and an entry whose output is unchanged
+ * since the last run is skipped together
+ * with any archive inside it. The entry's own record is only written once
+ * the outputs of that archive are recorded as well.
+ *
+ * PYZ and package entries are decoded into memory once, unless they are
+ * already resident in the mapped view, written from there and then handed to
+ * expandNested(), so a nested archive is never read back from disk. Those
+ * larger than `options.streamingThreshold` are streamed to their output like
+ * any other large entry and expanded from a mapping of the written file, see
+ * expandFromOutput(). Binaries and data rarely hold an archive, so unless
+ * they are resident they are streamed through a ProbeSink that keeps only
+ * their first bytes and the last NESTED_COOKIE_WINDOW bytes; only an entry
+ * starting with a PYZ header or ending with a cookie is expanded from its
+ * output.
+ *
+ * @param entry The TOC entry to extract.
+ * @param outputDir Directory of this archive's output.
+ * @param context Pool, inflate backend and settings of the run.
+ * @param depth Nesting depth of this archive, 0 for the archive on disk.
+ * @param keepAlive Owner of this archive for nested ones, captured by follow-up tasks.
+ * @param parent Pending record of the entry this archive was expanded from, or nullptr.
+ * @return true if the entry and any archive inside it were processed, false otherwise.
+ */
+bool PyInstArchive::extractEntry(const TocTable::Entry& entry, const std::filesystem::path& outputDir, ExtractionContext& context, unsigned depth, const std::shared_ptr<const void>& keepAlive, const std::shared_ptr<PendingRecord>& parent) {
+    const ExtractOptions& options = context.options;
+    std::filesystem::path path = entryOutputPath(outputDir, entry.getName());
+    const PycFormat* pycFormat = nullptr;
+    if (options.pycHeaders && entry.getType() == 's') {
+        pycFormat = findPycFormat(pymaj, pymin);
+    }
+    if (pycFormat != nullptr) {
+        path += ".pyc";
+    }
+
+    std::string rawHash;
+    if (context.manifest != nullptr) {
+        rawHash = context.knownHash(path, entry.getCompressedDataSize(), entry.getPosition());
+        if (rawHash.empty()) {
+            rawHash = hashEntry(entry, std::max<size_t>(options.streamChunkSize, 4096));
+        }
+        if (!rawHash.empty() && context.isUnchanged(path, entry.getCompressedDataSize(), rawHash, parent.get())) {
+            return true;
+        }
+    }
+
+    const uint8_t* payload = nullptr;
+    size_t payloadSize = 0;
+    std::vector<uint8_t> decoded;
+    bool expandOutput = false;
+    bool probe = false;
+    char type = entry.getType();
+    bool archiveType = type == 'a' || type == 'z' || type == 'Z';
+    if (depth < options.maxNestingDepth && (archiveType || type == 'b' || type == 'd' || type == 'x')) {
+        if (entry.getCompressionFlag() == 0) {
+            payload = viewAt(entry.getPosition(), entry.getCompressedDataSize());
+            payloadSize = entry.getCompressedDataSize();
+        }
+        if (payload == nullptr && !archiveType) {
+            probe = true;
+        }
+        else if (payload == nullptr && entry.getUncompressedDataSize() > options.streamingThreshold) {
+            expandOutput = true;
+        }
+        else if (payload == nullptr) {
+            BufferSink buffer;
+            if (!writeEntryPayload(entry, buffer, context.decompressor, options)) {
+                return false;
+            }
+            decoded.swap(buffer.getBuffer());
+            payload = decoded.data();
+            payloadSize = decoded.size();
+        }
+    }
+
+    std::unique_ptr<OutputSink> sink = context.openSink(path);
+    if (!sink) {
+        logError("Could not write ", entry.getName());
+        return false;
+    }
+    if (pycFormat != nullptr) {
+        uint8_t header[MAX_PYC_HEADER_SIZE];
+        if (!sink->write(header, buildPycHeader(*pycFormat, header))) {
+            logError("Could not write ", entry.getName());
+            return false;
+        }
+    }
+    std::unique_ptr<ProbeSink> probeSink;
+    if (probe) {
+        probeSink = std::make_unique<ProbeSink>(*sink, NESTED_HEAD_SIZE, NESTED_COOKIE_WINDOW);
+    }
+    OutputSink& out = probeSink ? static_cast<OutputSink&>(*probeSink) : *sink;
+    bool written = !decoded.empty()
+        ? out.write(decoded.data(), decoded.size())
+        : writeEntryPayload(entry, out, context.decompressor, options);
+    if (!written) {
+        return false;
+    }
+    if (!out.commit()) {
+        logError("Could not write ", entry.getName());
+        return false;
+    }
+    if (probeSink) {
+        const std::vector<uint8_t>& head = probeSink->getHead();
+        size_t tailLength = probeSink->tailLength();
+        expandOutput = PyzArchive::isPyz(head.data(), head.size())
+            || (tailLength >= MAGIC_SIZE && findLastMagic(probeSink->tailData(), tailLength) != nullptr);
+    }
+    std::shared_ptr<PendingRecord> record;
+    if (context.manifest != nullptr) {
+        record = context.recordOutput(path, entry.getCompressedDataSize(), entry.getPosition(), rawHash, parent);
+    }
+
+    bool expanded = true;
+    if (payload != nullptr) {
+        expanded = expandNested(path, payload, payloadSize, decoded, context, depth, keepAlive, record);
+    }
+    else if (expandOutput) {
+        expanded = expandFromOutput(entry, path, context, depth, record);
+    }
+    if (!expanded && record) {
+        record->incomplete = true;
+    }
+    return expanded;
+}
+
+/**
+ * @brief Schedules the contents of an archive entry that was streamed to its output.
+ *
+ * The output at `path` is memory-mapped and the mapping is handed to
+ * expandNested() as a borrowed view, owned by the nested tasks, so memory use
+ * stays bounded by the streaming settings. With a content store there is no
+ * file at `path`; the entry is then decoded again into memory if it is within
+ * `options.streamingThreshold`. Otherwise, or if the file cannot be mapped,
+ * the entry is left unexpanded, which is logged.
+ *
+ * @param entry The TOC entry that was extracted.
+ * @param path Output path of the entry.
+ * @param context Pool, inflate backend and settings of the run.
+ * @param depth Nesting depth of this archive.
+ * @param record Pending manifest record of the entry, held by the nested tasks; may be null.
+ * @return true unless a detected archive could not be parsed.
+ */
+bool PyInstArchive::expandFromOutput(const TocTable::Entry& entry, const std::filesystem::path& path, ExtractionContext& context, unsigned depth, const std::shared_ptr<PendingRecord>& record) {
+    std::vector<uint8_t> decoded;
+    if (context.store != nullptr && entry.getUncompressedDataSize() <= context.options.streamingThreshold) {
+        BufferSink buffer;
+        if (!writeEntryPayload(entry, buffer, context.decompressor, context.options)) {
+            return false;
+        }
+        decoded.swap(buffer.getBuffer());
+        return expandNested(path, decoded.data(), decoded.size(), decoded, context, depth, nullptr, record);
+    }
+    auto mapping = std::make_shared<MappedFile>();
+    if (context.store != nullptr || !mapping->open(path.u8string()) || !mapping->map()) {
+        logInfo("Not expanding ", path.u8string(), ": its output cannot be mapped");
+        return true;
+    }
+    return expandNested(path, mapping->data(), static_cast<size_t>(mapping->size()), decoded, context, depth, mapping, record);
+}
+
+/**
+ * @brief Reads the PYZ encryption key from the pyimod00_crypto_key module.
+ *
+ * Archives built with `--key` carry a module whose only statement is
+ * `key = '...'`. Its code object is decoded with MarshalReader and the first
+ * string constant is taken as the key. A leading pyc header is skipped if the
+ * module was stored with one.
+ *
+ * @param decompressor Inflate backend for the entry.
+ * @param options Extraction settings.
+ * @return The key, or an empty string if the archive has no usable key module.
+ */
+std::string PyInstArchive::findCryptoKey(const Decompressor& decompressor, const ExtractOptions& options) {
+    size_t row = tocList.find("pyimod00_crypto_key");
+    if (row == TocTable::npos) {
+        return std::string();
+    }
+    BufferSink buffer;
+    if (!writeEntryPayload(tocList[row], buffer, decompressor, options)) {
+        return std::string();
+    }
+    const std::vector<uint8_t>& payload = buffer.getBuffer();
+    size_t offset = 0;
+    if (payload.size() >= 4 && payload[2] == '\r' && payload[3] == '\n') {
+        const PycFormat* format = findPycFormatByMagic(static_cast<uint16_t>(payload[0] | (payload[1] << 8)));
+        offset = format != nullptr ? format->headerSize : MAX_PYC_HEADER_SIZE;
+    }
+    if (offset >= payload.size()) {
+        return std::string();
+    }
+
+    Arena arena;
+    try {
+        const MarshalObject* module = MarshalReader(payload.data() + offset, payload.size() - offset, arena, pymaj, pymin).read();
+        if (module->type != MarshalType::Code || module->code->consts == nullptr || !module->code->consts->isSequence()) {
+            return std::string();
+        }
+        const MarshalObject* consts = module->code->consts;
+        for (uint32_t i = 0; i < consts->size; ++i) {
+            if (consts->items[i]->isString() && consts->items[i]->size > 0) {
+                return std::string(consts->items[i]->text());
+            }
+        }
+    }
+    catch (const std::runtime_error& e) {
+        logError("Failed to decode pyimod00_crypto_key: ", e.what());
+    }
+    return std::string();
+}
+
+/**
+ * @brief Schedules the contents of an archive found inside an entry.
+ *
+ * PYZ archives are recognized by their header. CArchives, either packages of
+ * their own or complete onefile executables, end with the cookie, so only the
+ * last NESTED_COOKIE_WINDOW bytes are searched and ordinary binaries cost next
+ * to nothing. A nested archive borrows `payload` when it points into this
+ * archive and takes over `decoded` otherwise; its entries are submitted to the
+ * same pool, with a shared pointer to it captured by every task, and extracted
+ * into `<path>_extracted`.
+ *
+ * @param path Output path of the entry.
+ * @param payload The decoded entry bytes.
+ * @param size Number of bytes at `payload`.
+ * @param decoded Buffer holding the payload if it is not a view into this archive.
+ * @param context Pool, inflate backend and settings of the run.
+ * @param depth Nesting depth of this archive.
+ * @param keepAlive Owner of this archive for nested ones.
+ * @param record Pending manifest record of the entry, held by the nested tasks; may be null.
+ * @return true unless a detected archive could not be parsed.
+ */
+bool PyInstArchive::expandNested(const std::filesystem::path& path, const uint8_t* payload, size_t size, std::vector<uint8_t>& decoded, ExtractionContext& context, unsigned depth, const std::shared_ptr<const void>& keepAlive, const std::shared_ptr<PendingRecord>& record) {
+    std::filesystem::path nestedDir = path;
+    nestedDir += "_extracted";
+    bool borrowed = decoded.empty() || payload != decoded.data();
+
+    if (PyzArchive::isPyz(payload, size)) {
+        if (!context.options.extractPyz) {
+            return true;
+        }
+        auto pyz = borrowed ? std::make_shared<PyzArchive>(payload, size, keepAlive) : std::make_shared<PyzArchive>(std::move(decoded));
+        logInfo("Extracting PYZ archive ", path.u8string());
+        if (!pyz->parse()) {
+            return false;
+        }
+        if (pyz->isEncrypted()) {
+            const std::string& key = context.options.pyzKey.empty() ? findCryptoKey(context.decompressor, context.options) : context.options.pyzKey;
+            if (key.empty()) {
+                logError("PYZ archive ", path.u8string(), " is encrypted and no key was found");
+                return false;
+            }
+            if (!pyz->setKey(key)) {
+                return false;
+            }
+        }
+        ++context.nestedArchives;
+        pyz->scheduleExtraction(context, nestedDir, pyz, record);
+        return true;
+    }
+
+    size_t window = std::min(size, NESTED_COOKIE_WINDOW);
+    if (window < MAGIC_SIZE || findLastMagic(payload + size - window, window) == nullptr) {
+        return true;
+    }
+    auto nested = borrowed
+        ? std::make_shared<PyInstArchive>(payload, size, path.u8string(), keepAlive)
+        : std::make_shared<PyInstArchive>(std::move(decoded), path.u8string());
+    if (!nested->checkFile() || !nested->getCArchiveInfo()) {
+        return false;
+    }
+    ++context.nestedArchives;
+    nested->scheduleEntries(context, nestedDir, depth + 1, nested, record);
+    return true;
+}
+
+/**
+ * @brief Submits the entries of this archive to the pool of a run.
+ *
+ * Entry sizes in real archives are heavily skewed, so entries are dispatched
+ * largest first, using the compressed plus uncompressed size from the TOC as
+ * the cost estimate, and idle workers steal pending work from busy ones. This
+ * starts the big shared libraries early and lets thousands of small modules
+ * fill the remaining gaps instead of leaving cores idle at the tail. The
+ * entry filter applies to the top-level archive only; nested archives are
+ * expanded completely.
+ *
+ * @param context Pool, inflate backend and settings of the run.
+ * @param outputDir Directory of this archive's output.
+ * @param depth Nesting depth of this archive, 0 for the archive on disk.
+ * @param keepAlive Owner of this archive, captured by every task; null for the archive on disk.
+ * @param parent Pending record of the entry this archive was expanded from, captured by every task; may be null.
+ * @return Number of entries submitted.
+ */
+size_t PyInstArchive::scheduleEntries(ExtractionContext& context, const std::filesystem::path& outputDir, unsigned depth, const std::shared_ptr<const void>& keepAlive, const std::shared_ptr<PendingRecord>& parent) {
+    const auto& compressed = tocList.compressedSizes();
+    const auto& uncompressed = tocList.uncompressedSizes();
+    auto entryCost = [&](size_t row) {
+        return static_cast<uint64_t>(compressed[row]) + uncompressed[row];
+    };
+    std::vector<size_t> order;
+    order.reserve(tocList.size());
+    for (size_t row = 0; row < tocList.size(); ++row) {
+        if (depth > 0 || context.options.filter.matches(tocList[row])) {
+            order.push_back(row);
+        }
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return entryCost(a) > entryCost(b);
+    });
+
+    context.files += order.size();
+    for (size_t row : order) {
+        TocTable::Entry entry = tocList[row];
+        context.pool.submit([this, entry, outputDir, &context, depth, keepAlive, parent] {
+            bool extracted = false;
+            try {
+                extracted = extractEntry(entry, outputDir, context, depth, keepAlive, parent);
+            }
+            catch (const std::exception& e) {
+                logError("Failed to extract ", entry.getName(), ": ", e.what());
+            }
+            if (!extracted) {
+                ++context.failures;
+                if (parent) {
+                    parent->incomplete = true;
+                }
+            }
+        }, entryCost(row));
+    }
+    return order.size();
+}
+
+/**
+ * @brief Extracts every TOC entry into a directory using a pool of worker threads.
+ *
+ * Archives found inside entries (PYZ archives, nested packages and bundled
+ * onefile executables) are expanded recursively up to
+ * `options.maxNestingDepth` levels, on the same pool and without intermediate
+ * files. Per-thread utilization is available afterwards through
+ * getExtractionStats(). Entries rejected by `options.filter` are skipped when
+ * the entries are scheduled, so none of their payload bytes are read; the
+ * TOC itself is left as it is. Requires getCArchiveInfo() to have run.
+ *
+ * With `options.contentStore` the outputs are filed in that store under their
+ * SHA-256 instead, and `outputDir` only receives a manifest mapping each
+ * output path to its digest. With `options.incremental` a manifest of the raw
+ * entry hashes is kept in `outputDir` and outputs unchanged since the last
+ * run are left in place. With `options.resume` every finished output is
+ * journaled as it completes, so repeating an interrupted run skips the work
+ * that was already done; the journal is removed once a run succeeds. Outputs
+ * are written as `.part` files and renamed when complete, so an interrupted
+ * run never leaves a truncated file under a final name.
+ *
+ * @param outputDir Directory to extract into; created if missing.
+ * @param options Thread count, inflate backend, nesting and store settings.
+ * @return true if every entry, nested ones included, was extracted, false otherwise.
+ */
+bool PyInstArchive::extractAll(const std::string& outputDir, const ExtractOptions& options) {
+    if (options.pycHeaders && findPycFormat(pymaj, pymin) == nullptr) {
+        logInfo("No pyc magic known for Python ", static_cast<int>(pymaj), ".", static_cast<int>(pymin),
+            "; scripts are written without a header");
+    }
+    // Size and modification time identify the archive file between runs
+    std::string source;
+    if (!inMemory) {
+        std::error_code ec;
+        auto modified = std::filesystem::last_write_time(std::filesystem::u8path(filePath), ec);
+        if (!ec) {
+            source = std::to_string(fileSize) + ' ' + std::to_string(modified.time_since_epoch().count());
+        }
+    }
+    return runExtraction(std::filesystem::u8path(outputDir), options, source, [this](ExtractionContext& context) {
+        extractionStats.skipped = tocList.size() - scheduleEntries(context, context.outputRoot, 0, nullptr, nullptr);
+    }, extractionStats);
+}
+
+/**
+ * @brief Extracts every TOC entry with the default options and the given thread count.
+ *
+ * @param outputDir Directory to extract into; created if missing.
+ * @param threads Number of worker threads, 0 for one per hardware thread.
+ * @return true if every entry was extracted, false if any entry failed.
+ */
+bool PyInstArchive::extractAll(const std::string& outputDir, unsigned threads) {
+    ExtractOptions options;
+    options.threads = threads;
+    return extractAll(outputDir, options);
+}
@@ -0,0 +1,451 @@
+#include "PyzArchive.h"
+#include "PycHeader.h"
+#include "Logger.h"
+#include "MarshalReader.h"
+#include "AesCipher.h"
+#include "Sha256.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+namespace {
+
+const uint8_t PYZ_MAGIC[4] = { 'P', 'Y', 'Z', 0 };
+
+// Checks the two-byte zlib stream header (deflate, valid check bits)
+bool isZlibHeader(const uint8_t* p) {
+    return (p[0] & 0x0F) == 8 && (p[0] >> 4) <= 7 && ((p[0] << 8) | p[1]) % 31 == 0;
+}
+
+// Reads an integer TOC field; older builds store the is-package flag as a bool
+bool tocInteger(const MarshalObject* value, int64_t& result) {
+    switch (value->type) {
+    case MarshalType::Int:
+        result = value->integer;
+        return true;
+    case MarshalType::False:
+    case MarshalType::True:
+        result = value->type == MarshalType::True;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Converts a dotted module name into its output path below the extraction root.
+ *
+ * Namespace packages map to a directory and data entries keep their name.
+ */
+std::filesystem::path modulePath(const std::filesystem::path& outputDir, const PyzModule& module) {
+    std::string name = module.name;
+    if (module.type == 2) {
+        return entryOutputPath(outputDir, name);
+    }
+    std::replace(name.begin(), name.end(), '.', '/');
+    if (module.type == 3) {
+        return entryOutputPath(outputDir, name);
+    }
+    if (module.type == 1) {
+        name += "/__init__";
+    }
+    name += ".pyc";
+    return entryOutputPath(outputDir, name);
+}
+
+} // namespace
+
+PyzArchive::PyzArchive(const uint8_t* data, size_t size, std::shared_ptr<const void> dataOwner)
+    : dataOwner(std::move(dataOwner)), data(data), size(size), pycMagic(), cipherMode(AesMode::Ctr) {}
+
+PyzArchive::PyzArchive(std::vector<uint8_t>&& buffer)
+    : storage(std::move(buffer)), data(storage.data()), size(storage.size()), pycMagic(), cipherMode(AesMode::Ctr) {}
+
+/**
+ * @brief Checks whether a buffer starts with the PYZ archive header.
+ *
+ * @param data Start of the buffer.
+ * @param size Size of the buffer.
+ * @return true if the buffer looks like a PYZ archive.
+ */
+bool PyzArchive::isPyz(const uint8_t* data, size_t size) {
+    return size >= HEADER_SIZE && std::memcmp(data, PYZ_MAGIC, sizeof(PYZ_MAGIC)) == 0;
+}
+
+/**
+ * @brief Parses the PYZ header and its marshalled table of contents.
+ *
+ * The header holds `PYZ\0`, the pyc magic of the building Python and the
+ * big-endian offset of the TOC. The TOC is a marshalled list (a dict in older
+ * builds) mapping each module name to a `(type, position, length)` tuple.
+ *
+ * @return true if the TOC was parsed, false if the data is not a valid PYZ archive.
+ */
+bool PyzArchive::parse() {
+    modules.clear();
+    if (!isPyz(data, size)) {
+        logError("Missing PYZ archive magic");
+        return false;
+    }
+    std::memcpy(pycMagic, data + 4, sizeof(pycMagic));
+    uint32_t tocPos = (static_cast<uint32_t>(data[8]) << 24) | (static_cast<uint32_t>(data[9]) << 16) |
+        (static_cast<uint32_t>(data[10]) << 8) | static_cast<uint32_t>(data[11]);
+    if (tocPos < HEADER_SIZE || tocPos >= size) {
+        logError("PYZ TOC offset is out of range");
+        return false;
+    }
+    if (!parseTOC(data + tocPos, size - tocPos)) {
+        modules.clear();
+        return false;
+    }
+    logInfo("Found ", modules.size(), " modules in PYZ archive");
+    return true;
+}
+
+/**
+ * @brief Decodes the marshalled TOC into the module list.
+ *
+ * @param toc Start of the marshalled TOC.
+ * @param size Bytes available after the TOC offset.
+ * @return true if every record was decoded, false otherwise.
+ */
+bool PyzArchive::parseTOC(const uint8_t* toc, size_t size) {
+    // The TOC holds no code objects, so an unknown magic only matters for the module bodies
+    const PycFormat* format = findPycFormatByMagic(static_cast<uint16_t>(pycMagic[0] | (pycMagic[1] << 8)));
+    Arena arena;
+    const MarshalObject* root;
+    try {
+        root = MarshalReader(toc, size, arena, format ? format->major : 0, format ? format->minor : 0).read();
+    }
+    catch (const std::runtime_error& e) {
+        logError("Failed to parse PYZ TOC: ", e.what());
+        return false;
+    }
+
+    // Lists hold (name, record) pairs, dicts alternate names and records
+    std::vector<std::pair<const MarshalObject*, const MarshalObject*>> records;
+    if (root->type == MarshalType::Dict) {
+        for (uint32_t i = 0; i < root->size; ++i) {
+            records.emplace_back(root->items[2 * i], root->items[2 * i + 1]);
+        }
+    }
+    else if (root->isSequence()) {
+        for (uint32_t i = 0; i < root->size; ++i) {
+            const MarshalObject* item = root->items[i];
+            if (!item->isSequence() || item->size != 2) {
+                logError("Malformed PYZ TOC entry");
+                return false;
+            }
+            records.emplace_back(item->items[0], item->items[1]);
+        }
+    }
+    else {
+        logError("Unexpected PYZ TOC type");
+        return false;
+    }
+
+    modules.reserve(records.size());
+    for (const auto& record : records) {
+        const MarshalObject* name = record.first;
+        const MarshalObject* fields = record.second;
+        int64_t type, position, length;
+        if (!name->isString() || !fields->isSequence() || fields->size != 3 || !tocInteger(fields->items[0], type) ||
+            !tocInteger(fields->items[1], position) || !tocInteger(fields->items[2], length)) {
+            logError("Malformed PYZ TOC entry");
+            return false;
+        }
+        if (position < 0 || length < 0 || static_cast<uint64_t>(position) > this->size ||
+            static_cast<uint64_t>(length) > this->size - static_cast<uint64_t>(position)) {
+            logError("PYZ module ", name->text(), " lies outside the archive");
+            return false;
+        }
+        modules.push_back({ std::string(name->text()), static_cast<uint8_t>(type),
+            static_cast<uint64_t>(position), static_cast<uint64_t>(length) });
+    }
+    return true;
+}
+
+/**
+ * @brief Prints the module names and compressed sizes.
+ */
+void PyzArchive::viewModules() const {
+    for (const auto& module : modules) {
+        std::cout << module.name << " (" << module.length << " bytes)\n";
+    }
+}
+
+/**
+ * @brief Inflates the code object (or data) of a module.
+ *
+ * The PYZ TOC does not record uncompressed sizes, so the module is inflated
+ * through the streaming path into a growing buffer.
+ *
+ * @param module The module from getModules().
+ * @param decompressor Inflate backend.
+ * @param code Receives the marshalled code object, without a pyc header.
+ * @return true if the module was inflated, false on corrupt or encrypted data.
+ */
+bool PyzArchive::readModule(const PyzModule& module, const Decompressor& decompressor, std::vector<uint8_t>& code) const {
+    code.clear();
+    return inflateModule(module, decompressor, [&](const uint8_t* chunk, size_t len) {
+        code.insert(code.end(), chunk, chunk + len);
+        return true;
+    });
+}
+
+/**
+ * @brief Decrypts (when a key is set) and inflates a module into a sink.
+ *
+ * Encrypted modules start with the 16-byte IV. They are decrypted in
+ * fixed-size chunks on the calling thread right before inflate, so the
+ * decryption runs inside the parallel extraction and never needs a buffer
+ * of the whole module.
+ *
+ * @param module The module to decode.
+ * @param decompressor Inflate backend.
+ * @param sink Receives the inflated bytes.
+ * @return true if the module was decoded, false otherwise.
+ */
+bool PyzArchive::inflateModule(const PyzModule& module, const Decompressor& decompressor, const InflateSink& sink) const {
+    const uint8_t* input = data + module.position;
+    size_t remaining = static_cast<size_t>(module.length);
+    const size_t chunkSize = 64 * 1024;
+
+    if (!cipher) {
+        return decompressor.inflateStream(
+            [&](const uint8_t*& chunk, size_t& len) {
+                chunk = input;
+                len = remaining;
+                remaining = 0;
+                return true;
+            },
+            sink, chunkSize);
+    }
+
+    if (remaining < AES_BLOCK_SIZE) {
+        return false;
+    }
+    AesDecryptor decryptor(*cipher, cipherMode, input);
+    input += AES_BLOCK_SIZE;
+    remaining -= AES_BLOCK_SIZE;
+    std::vector<uint8_t> plain(std::min(remaining, chunkSize));
+    return decompressor.inflateStream(
+        [&](const uint8_t*& chunk, size_t& len) {
+            len = std::min(remaining, plain.size());
+            decryptor.process(input, plain.data(), len);
+            chunk = plain.data();
+            input += len;
+            remaining -= len;
+            return true;
+        },
+        sink, chunkSize);
+}
+
+/**
+ * @brief Reports whether the modules are encrypted.
+ *
+ * Plain modules are zlib streams, so the first modules are checked for a
+ * valid zlib header.
+ *
+ * @return true if a module does not start like a zlib stream.
+ */
+bool PyzArchive::isEncrypted() const {
+    size_t checked = 0;
+    for (const auto& module : modules) {
+        if (module.length < 2) {
+            continue;
+        }
+        if (!isZlibHeader(data + module.position)) {
+            return true;
+        }
+        if (++checked == 8) {
+            break;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Sets the key used to decrypt the modules of an archive built with `--key`.
+ *
+ * The key is normalized like PyInstaller's PyiBlockCipher: truncated to 16
+ * bytes, or left-padded with '0'. PyInstaller 4.0 and later encrypt with
+ * AES-CTR and 3.x with AES-CFB-8; the mode is detected by decrypting the
+ * start of the first modules with each and checking for a zlib header.
+ * Call after parse().
+ *
+ * @param key The key, usually the string from pyimod00_crypto_key.
+ * @return true if the key decrypts the modules, false otherwise.
+ */
+bool PyzArchive::setKey(std::string_view key) {
+    uint8_t keyBytes[AES_BLOCK_SIZE];
+    std::memset(keyBytes, '0', sizeof(keyBytes));
+    size_t keyLen = std::min(key.size(), AES_BLOCK_SIZE);
+    std::memcpy(keyBytes + AES_BLOCK_SIZE - keyLen, key.data(), keyLen);
+    auto candidate = std::make_unique<AesCipher>(keyBytes);
+
+    for (AesMode mode : { AesMode::Ctr, AesMode::Cfb8 }) {
+        size_t checked = 0;
+        bool valid = true;
+        for (const auto& module : modules) {
+            if (module.length < AES_BLOCK_SIZE + 2) {
+                continue;
+            }
+            uint8_t head[2];
+            AesDecryptor decryptor(*candidate, mode, data + module.position);
+            decryptor.process(data + module.position + AES_BLOCK_SIZE, head, sizeof(head));
+            if (!isZlibHeader(head)) {
+                valid = false;
+                break;
+            }
+            if (++checked == 8) {
+                break;
+            }
+        }
+        if (valid && checked > 0) {
+            cipher = std::move(candidate);
+            cipherMode = mode;
+            logInfo("Decrypting PYZ modules with AES-", mode == AesMode::Ctr ? "CTR" : "CFB8",
+                cipher->isHardwareAccelerated() ? " (AES-NI)" : "");
+            return true;
+        }
+    }
+    logError("The key does not decrypt the PYZ modules");
+    return false;
+}
+
+/**
+ * @brief Writes one module as a .pyc file.
+ *
+ * The inflated code object is streamed straight to the file after a pyc
+ * header carrying the magic from the PYZ header.
+ *
+ * @param module The module to extract.
+ * @param outputDir The extraction root.
+ * @param context Inflate backend and output store of the run.
+ * @param parent Pending record of the entry holding this archive, or nullptr.
+ * @return true if the module was written, false otherwise.
+ */
+bool PyzArchive::extractModule(const PyzModule& module, const std::filesystem::path& outputDir, ExtractionContext& context, const std::shared_ptr<PendingRecord>& parent) {
+    std::filesystem::path path = modulePath(outputDir, module);
+    std::string rawHash;
+    if (context.manifest != nullptr && module.position <= size && module.length <= size - module.position) {
+        rawHash = context.knownHash(path, module.length, module.position);
+        if (rawHash.empty()) {
+            Sha256 hash;
+            hash.update(data + module.position, static_cast<size_t>(module.length));
+            rawHash = hash.finishHex();
+        }
+        if (context.isUnchanged(path, module.length, rawHash, parent.get())) {
+            return true;
+        }
+    }
+
+    std::unique_ptr<OutputSink> sink = context.openSink(path);
+    if (!sink) {
+        logError("Could not write ", module.name);
+        return false;
+    }
+    if (module.type != 2) {
+        const PycFormat* format = findPycFormatByMagic(static_cast<uint16_t>(pycMagic[0] | (pycMagic[1] << 8)));
+        uint8_t header[MAX_PYC_HEADER_SIZE] = {};
+        std::memcpy(header, pycMagic, sizeof(pycMagic));
+        size_t headerSize = format != nullptr ? format->headerSize : MAX_PYC_HEADER_SIZE;
+        if (!sink->write(header, headerSize)) {
+            logError("Could not write ", module.name);
+            return false;
+        }
+    }
+
+    bool sinkFailed = false;
+    bool inflated = inflateModule(module, context.decompressor, [&](const uint8_t* chunk, size_t len) {
+        sinkFailed = !sink->write(chunk, len);
+        return !sinkFailed;
+    });
+    if (sinkFailed) {
+        logError("Could not write ", module.name);
+        return false;
+    }
+    if (!inflated) {
+        logError("Failed to decompress module ", module.name, cipher ? "" : "; the archive may be encrypted");
+        return false;
+    }
+    if (!sink->commit()) {
+        logError("Could not write ", module.name);
+        return false;
+    }
+    if (context.manifest != nullptr) {
+        context.recordOutput(path, module.length, module.position, rawHash, parent);
+    }
+    return true;
+}
+
+/**
+ * @brief Submits every module to the pool of an extraction run.
+ *
+ * Modules are written as `<package path>/<module>.pyc`, packages as
+ * `<package>/__init__.pyc`, and are dispatched largest first like the
+ * CArchive entries. Used directly for PYZ archives nested in a CArchive, so
+ * their modules share the workers of the outer extraction. Namespace
+ * packages are only directories; they are created right away and are not
+ * counted as files.
+ *
+ * @param context Pool, inflate backend and counters of the run.
+ * @param outputDir Directory to extract into.
+ * @param keepAlive Owner of this reader, captured by every task; may be null if it outlives the run.
+ * @param parent Pending record of the entry holding this archive, captured by every task; may be null.
+ */
+void PyzArchive::scheduleExtraction(ExtractionContext& context, const std::filesystem::path& outputDir, const std::shared_ptr<const void>& keepAlive, const std::shared_ptr<PendingRecord>& parent) {
+    std::vector<size_t> order(modules.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return modules[a].length > modules[b].length;
+    });
+
+    for (size_t index : order) {
+        if (modules[index].type == 3) {
+            // Namespace packages have no code, only a directory, which a content store does not keep
+            std::error_code ec;
+            if (context.store == nullptr && !std::filesystem::create_directories(modulePath(outputDir, modules[index]), ec) && ec) {
+                logError("Could not create ", modules[index].name);
+                ++context.files;
+                ++context.failures;
+                if (parent) {
+                    parent->incomplete = true;
+                }
+            }
+            continue;
+        }
+        ++context.files;
+        context.pool.submit([this, index, outputDir, &context, keepAlive, parent] {
+            bool extracted = false;
+            try {
+                extracted = extractModule(modules[index], outputDir, context, parent);
+            }
+            catch (const std::exception& e) {
+                logError("Failed to extract module ", modules[index].name, ": ", e.what());
+            }
+            if (!extracted) {
+                ++context.failures;
+                if (parent) {
+                    parent->incomplete = true;
+                }
+            }
+        }, modules[index].length);
+    }
+}
+
+/**
+ * @brief Extracts every module into a directory using a pool of worker threads.
+ *
+ * @param outputDir Directory to extract into; created if missing.
+ * @param options Thread count, inflate backend, content store, incremental and resume modes.
+ * @return true if every module was extracted, false if any module failed.
+ */
+bool PyzArchive::extractAll(const std::filesystem::path& outputDir, const ExtractOptions& options) {
+    return runExtraction(outputDir, options, std::string(), [this](ExtractionContext& context) {
+        scheduleExtraction(context, context.outputRoot, nullptr);
+    }, extractionStats);
+}
@@ -0,0 +1,74 @@
+#ifndef PYZARCHIVE_H
+#define PYZARCHIVE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "PyInstArchive.h"
+#include "AesCipher.h"
+
+// Module record from the TOC of a PYZ archive
+struct PyzModule {
+    std::string name;              // Dotted module name
+    uint8_t type;                  // 0 module, 1 package, 2 data, 3 namespace package; older builds store is-package
+    uint64_t position;             // Offset of the compressed code object in the PYZ
+    uint64_t length;               // Length of the compressed code object
+};
+
+// Reader for the PYZ archive (PYZ-00.pyz) holding the application's pure-Python modules
+class PyzArchive {
+public:
+    // Constructors, either borrowing a view (kept valid by `dataOwner` or the caller) or taking ownership of a buffer
+    PyzArchive(const uint8_t* data, size_t size, std::shared_ptr<const void> dataOwner = nullptr);
+    explicit PyzArchive(std::vector<uint8_t>&& buffer);
+
+    PyzArchive(const PyzArchive&) = delete;
+    PyzArchive& operator=(const PyzArchive&) = delete;
+
+    // Member functions
+    bool parse();
+    bool isEncrypted() const;
+    bool setKey(std::string_view key);
+    void viewModules() const;
+    bool readModule(const PyzModule& module, const Decompressor& decompressor, std::vector<uint8_t>& code) const;
+    bool extractAll(const std::filesystem::path& outputDir, const ExtractOptions& options);
+    void scheduleExtraction(ExtractionContext& context, const std::filesystem::path& outputDir, const std::shared_ptr<const void>& keepAlive, const std::shared_ptr<PendingRecord>& parent = nullptr);
+
+    const std::vector<PyzModule>& getModules() const {
+        return modules;
+    }
+
+    // The pyc magic of the Python version that built the archive, as stored in the header
+    const uint8_t* getPycMagic() const {
+        return pycMagic;
+    }
+
+    const ExtractionStats& getExtractionStats() const {
+        return extractionStats;
+    }
+
+    static bool isPyz(const uint8_t* data, size_t size);
+
+private:
+    bool parseTOC(const uint8_t* toc, size_t size);
+    bool inflateModule(const PyzModule& module, const Decompressor& decompressor, const InflateSink& sink) const;
+    bool extractModule(const PyzModule& module, const std::filesystem::path& outputDir, ExtractionContext& context, const std::shared_ptr<PendingRecord>& parent);
+
+    std::vector<uint8_t> storage;  // Owned archive bytes, empty when borrowing
+    std::shared_ptr<const void> dataOwner; // Keeps borrowed bytes alive, may be null
+    const uint8_t* data;           // Start of the archive
+    size_t size;                   // Size of the archive
+    uint8_t pycMagic[4];           // Pyc magic from the header
+    std::vector<PyzModule> modules; // Parsed TOC
+    std::unique_ptr<AesCipher> cipher; // Module cipher, set for encrypted archives
+    AesMode cipherMode;            // Stream mode of the module cipher
+    ExtractionStats extractionStats; // Statistics of the last extractAll() run
+
+    static const size_t HEADER_SIZE = 12;
+};
+
+#endif // PYZARCHIVE_H
@@ -0,0 +1,31 @@
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+
+// Size of a SHA-256 digest
+const size_t SHA256_DIGEST_SIZE = 32;
+
+// Incremental SHA-256 (FIPS 180-4) used to identify output contents
+class Sha256 {
+public:
+    // Constructor
+    Sha256();
+
+    // Member functions
+    void update(const uint8_t* data, size_t len);
+    void finish(uint8_t digest[SHA256_DIGEST_SIZE]);
+    std::string finishHex();
+
+private:
+    void compress(const uint8_t* block);
+
+    uint32_t state[8];             // Chaining value
+    uint8_t block[64];             // Pending input that does not fill a block yet
+    size_t blockLen;               // Bytes in block
+    uint64_t totalLen;             // Bytes hashed so far
+};
+
+#endif // SHA256_H
@@ -0,0 +1,208 @@
+#include "ThreadPool.h"
+#include "Logger.h"
+#include <algorithm>
+#include <exception>
+
+// Pool and worker index of the calling thread, used to keep nested submits local
+static thread_local const ThreadPool* currentPool = nullptr;
+static thread_local unsigned currentWorker = 0;
+
+/**
+ * @brief Starts the worker threads.
+ *
+ * @param threads Number of workers; 0 selects std::thread::hardware_concurrency().
+ */
+ThreadPool::ThreadPool(unsigned threads)
+    : nextSequence(0), nextQueue(0), queued(0), stopping(false), pending(0),
+      statsStart(std::chrono::steady_clock::now()) {
+    if (threads == 0) {
+        threads = std::thread::hardware_concurrency();
+    }
+    if (threads == 0) {
+        threads = 1;
+    }
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (unsigned i = 0; i < threads; ++i) {
+        workers[i]->thread = std::thread(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+/**
+ * @brief Runs all remaining tasks and joins the worker threads.
+ */
+ThreadPool::~ThreadPool() {
+    wait();
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        stopping = true;
+    }
+    taskAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker->thread.join();
+    }
+}
+
+/**
+ * @brief Heap order of the worker queues: the most expensive task is on top.
+ *
+ * Among tasks of equal cost the one submitted first wins, so cost-less tasks
+ * keep running in submission order.
+ */
+bool ThreadPool::runsAfter(const Task& a, const Task& b) {
+    if (a.cost != b.cost) {
+        return a.cost < b.cost;
+    }
+    return a.sequence > b.sequence;
+}
+
+/**
+ * @brief Queues a task for execution on one of the workers.
+ *
+ * Every worker owns a queue ordered by the cost estimate, so the most
+ * expensive work is started first and cheap tasks fill the gaps at the end.
+ * Tasks submitted from a worker of this pool go to that worker's queue;
+ * others are spread round-robin. Idle workers steal the most expensive task
+ * from the other queues. Tasks may submit further tasks; wait() covers those
+ * as well. Exceptions escaping a task are logged and do not stop the worker.
+ *
+ * @param task The callable to run.
+ * @param cost Relative cost estimate, e.g. the number of bytes the task processes.
+ */
+void ThreadPool::submit(std::function<void()> task, uint64_t cost) {
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        ++pending;
+    }
+
+    unsigned target = currentPool == this
+        ? currentWorker
+        : nextQueue.fetch_add(1, std::memory_order_relaxed) % size();
+    Worker& worker = *workers[target];
+    {
+        std::lock_guard<std::mutex> lock(worker.mutex);
+        worker.queue.push_back(Task{ cost, nextSequence.fetch_add(1, std::memory_order_relaxed), std::move(task) });
+        std::push_heap(worker.queue.begin(), worker.queue.end(), &ThreadPool::runsAfter);
+    }
+    {
+        std::lock_guard<std::mutex> lock(idleMutex);
+        ++queued;
+    }
+    taskAvailable.notify_one();
+}
+
+/**
+ * @brief Blocks until every submitted task has finished.
+ */
+void ThreadPool::wait() {
+    std::unique_lock<std::mutex> lock(pendingMutex);
+    allDone.wait(lock, [this] { return pending == 0; });
+}
+
+/**
+ * @brief Clears the worker counters and restarts the utilization window.
+ *
+ * Must not be called while tasks are running.
+ */
+void ThreadPool::resetStats() {
+    for (auto& worker : workers) {
+        worker->stats = WorkerStats();
+    }
+    statsStart = std::chrono::steady_clock::now();
+}
+
+/**
+ * @brief Returns the counters of every worker since construction or resetStats().
+ *
+ * Utilization is the share of the wall time since the start of the window
+ * that the worker spent running tasks. Call after wait() for stable numbers.
+ *
+ * @return One entry per worker thread.
+ */
+std::vector<WorkerStats> ThreadPool::getWorkerStats() const {
+    double wallSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - statsStart).count();
+    std::vector<WorkerStats> result;
+    result.reserve(workers.size());
+    for (const auto& worker : workers) {
+        WorkerStats stats = worker->stats;
+        stats.utilization = wallSeconds > 0 ? stats.busySeconds / wallSeconds : 0;
+        result.push_back(stats);
+    }
+    return result;
+}
+
+/**
+ * @brief Takes the most expensive task from the worker's own queue or, failing that, from another worker.
+ *
+ * @param index Index of the calling worker.
+ * @param task Receives the task.
+ * @param stolen Set when the task came from another worker's queue.
+ * @return true if a task was found, false if all queues were empty.
+ */
+bool ThreadPool::popTask(unsigned index, Task& task, bool& stolen) {
+    for (unsigned i = 0; i < size(); ++i) {
+        Worker& victim = *workers[(index + i) % size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (victim.queue.empty()) {
+            continue;
+        }
+        std::pop_heap(victim.queue.begin(), victim.queue.end(), &ThreadPool::runsAfter);
+        task = std::move(victim.queue.back());
+        victim.queue.pop_back();
+        stolen = i != 0;
+        return true;
+    }
+    return false;
+}
+
+/**
+ * @brief Main loop of a worker thread: runs local or stolen tasks until shutdown.
+ *
+ * @param index Index of this worker.
+ */
+void ThreadPool::workerLoop(unsigned index) {
+    currentPool = this;
+    currentWorker = index;
+    Worker& self = *workers[index];
+
+    while (true) {
+        Task task;
+        bool stolen = false;
+        if (!popTask(index, task, stolen)) {
+            std::unique_lock<std::mutex> lock(idleMutex);
+            taskAvailable.wait(lock, [this] { return stopping || queued > 0; });
+            if (stopping && queued <= 0) {
+                return;
+            }
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(idleMutex);
+            --queued;
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        try {
+            task.run();
+        }
+        catch (const std::exception& e) {
+            logError("Worker task failed: ", e.what());
+        }
+        catch (...) {
+            logError("Worker task failed");
+        }
+        self.stats.busySeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        self.stats.tasks += 1;
+        self.stats.stolen += stolen ? 1 : 0;
+        self.stats.cost += task.cost;
+        // Captured state is released before wait() can return, so its destructors still see the caller's state
+        task.run = nullptr;
+
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        if (--pending == 0) {
+            allDone.notify_all();
+        }
+    }
+}
@@ -0,0 +1,76 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Per-worker counters collected by the pool
+struct WorkerStats {
+    size_t tasks = 0;              // Tasks executed by the worker
+    size_t stolen = 0;             // Tasks taken from another worker's queue
+    uint64_t cost = 0;             // Sum of the cost estimates of executed tasks
+    double busySeconds = 0;        // Time spent running tasks
+    double utilization = 0;        // busySeconds relative to the measured wall time
+};
+
+// Fixed-size pool of worker threads with cost-ordered, work-stealing queues
+class ThreadPool {
+public:
+    // Constructor, 0 threads means one per hardware thread
+    explicit ThreadPool(unsigned threads = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    // Member functions
+    void submit(std::function<void()> task, uint64_t cost = 0);
+    void wait();
+    void resetStats();
+    std::vector<WorkerStats> getWorkerStats() const;
+
+    unsigned size() const {
+        return static_cast<unsigned>(workers.size());
+    }
+
+private:
+    // A queued task with its cost estimate
+    struct Task {
+        uint64_t cost;                         // Larger tasks run first
+        uint64_t sequence;                     // Submission order among equal costs
+        std::function<void()> run;             // The work itself
+    };
+
+    // Queue and counters owned by one worker thread
+    struct Worker {
+        std::mutex mutex;                      // Guards queue
+        std::vector<Task> queue;               // Max-heap on cost
+        WorkerStats stats;                     // Only written by the owning thread
+        std::thread thread;                    // The worker thread
+    };
+
+    static bool runsAfter(const Task& a, const Task& b);
+    void workerLoop(unsigned index);
+    bool popTask(unsigned index, Task& task, bool& stolen);
+
+    std::vector<std::unique_ptr<Worker>> workers; // Workers and their queues
+    std::atomic<uint64_t> nextSequence;        // Sequence number of the next task
+    std::atomic<unsigned> nextQueue;           // Round-robin target for external submits
+    std::mutex idleMutex;                      // Guards queued and stopping for sleeping workers
+    std::condition_variable taskAvailable;     // Signalled when a task is queued or on shutdown
+    int64_t queued;                            // Tasks sitting in any queue
+    bool stopping;                             // Set by the destructor
+    std::mutex pendingMutex;                   // Guards pending
+    std::condition_variable allDone;           // Signalled when pending drops to zero
+    size_t pending;                            // Queued plus running tasks
+    std::chrono::steady_clock::time_point statsStart; // Start of the stats window
+};
+
+#endif // THREADPOOL_H
@@ -0,0 +1,163 @@
+#include "TocTable.h"
+#include "PyInstArchive.h"
+
+/**
+ * @brief Removes all entries and names from the table.
+ */
+void TocTable::clear() {
+    positionCol.clear();
+    cmprsdSizeCol.clear();
+    uncmprsdSizeCol.clear();
+    flagCol.clear();
+    typeCol.clear();
+    nameOffsets.assign(1, 0);
+    nameBlob.clear();
+    nameHashCol.clear();
+    indexSlots.clear();
+}
+
+/**
+ * @brief Pre-allocates all columns so that filling the table does not reallocate.
+ *
+ * @param entries Expected number of entries.
+ * @param nameBytes Expected total length of all names.
+ */
+void TocTable::reserve(size_t entries, size_t nameBytes) {
+    positionCol.reserve(entries);
+    cmprsdSizeCol.reserve(entries);
+    uncmprsdSizeCol.reserve(entries);
+    flagCol.reserve(entries);
+    typeCol.reserve(entries);
+    nameOffsets.reserve(entries + 1);
+    nameBlob.reserve(nameBytes);
+    nameHashCol.reserve(entries);
+
+    // Keep the index at most half full once all expected entries are added
+    size_t slotCount = 16;
+    while (slotCount < entries * 2) {
+        slotCount *= 2;
+    }
+    if (slotCount > indexSlots.size()) {
+        rebuildIndex(slotCount);
+    }
+}
+
+/**
+ * @brief Appends an entry to the table.
+ *
+ * The name is copied into the shared name blob, so views returned by name()
+ * remain valid until the table is cleared or another entry is added. Its hash
+ * is computed once here and the entry is inserted into the name index.
+ *
+ * @param position Absolute position of the entry in the file.
+ * @param cmprsdSize Compressed data size.
+ * @param uncmprsdSize Uncompressed data size.
+ * @param flag Compression flag.
+ * @param type Type of compressed data.
+ * @param name Name of the entry.
+ */
+void TocTable::add(uint64_t position, uint32_t cmprsdSize, uint32_t uncmprsdSize, uint8_t flag, char type, std::string_view name) {
+    if (nameOffsets.empty()) {
+        nameOffsets.push_back(0);
+    }
+    positionCol.push_back(position);
+    cmprsdSizeCol.push_back(cmprsdSize);
+    uncmprsdSizeCol.push_back(uncmprsdSize);
+    flagCol.push_back(flag);
+    typeCol.push_back(type);
+    nameBlob.append(name.data(), name.size());
+    nameOffsets.push_back(static_cast<uint32_t>(nameBlob.size()));
+    nameHashCol.push_back(hashName(name));
+
+    if (indexSlots.size() < size() * 2) {
+        rebuildIndex(indexSlots.empty() ? 16 : indexSlots.size() * 2);
+    }
+    else {
+        insertIntoIndex(size() - 1);
+    }
+}
+
+/**
+ * @brief Computes the 64-bit FNV-1a hash of an entry name.
+ *
+ * @param name The entry name.
+ * @return The hash used by the name index.
+ */
+uint64_t TocTable::hashName(std::string_view name) {
+    uint64_t hash = 14695981039346656037ull;
+    for (char c : name) {
+        hash ^= static_cast<uint8_t>(c);
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/**
+ * @brief Looks up an entry by its exact name.
+ *
+ * Probes the open-addressing index linearly starting at the slot selected by
+ * the name hash, comparing the stored hashes before the names themselves. When
+ * several entries share a name, the one added first is returned.
+ *
+ * @param name The entry name to look for.
+ * @return The row index of the entry, or npos if no entry has that name.
+ */
+size_t TocTable::find(std::string_view name) const {
+    if (indexSlots.empty()) {
+        return npos;
+    }
+    uint64_t hash = hashName(name);
+    size_t mask = indexSlots.size() - 1;
+    for (size_t slot = static_cast<size_t>(hash) & mask;; slot = (slot + 1) & mask) {
+        uint32_t value = indexSlots[slot];
+        if (value == 0) {
+            return npos;
+        }
+        size_t row = value - 1;
+        if (nameHashCol[row] == hash && this->name(row) == name) {
+            return row;
+        }
+    }
+}
+
+/**
+ * @brief Stores a row in the first free slot of its probe sequence.
+ *
+ * @param row Index of the row to insert; the index must have a free slot.
+ */
+void TocTable::insertIntoIndex(size_t row) {
+    size_t mask = indexSlots.size() - 1;
+    size_t slot = static_cast<size_t>(nameHashCol[row]) & mask;
+    while (indexSlots[slot] != 0) {
+        slot = (slot + 1) & mask;
+    }
+    indexSlots[slot] = static_cast<uint32_t>(row + 1);
+}
+
+/**
+ * @brief Resizes the name index and re-inserts all rows from their stored hashes.
+ *
+ * @param slotCount New number of slots; must be a power of two.
+ */
+void TocTable::rebuildIndex(size_t slotCount) {
+    indexSlots.assign(slotCount, 0);
+    for (size_t row = 0; row < nameHashCol.size(); ++row) {
+        insertIntoIndex(row);
+    }
+}
+
+/**
+ * @brief Materializes the row as a standalone CTOCEntry.
+ *
+ * @return A copy of the entry that owns its name.
+ */
+CTOCEntry TocTable::Entry::toEntry() const {
+    return CTOCEntry(
+        static_cast<uint32_t>(getPosition()),
+        getCompressedDataSize(),
+        getUncompressedDataSize(),
+        getCompressionFlag(),
+        getType(),
+        std::string(getName())
+    );
+}
@@ -0,0 +1,140 @@
+#ifndef TOCTABLE_H
+#define TOCTABLE_H
+
+#include <vector>
+#include <string>
+#include <string_view>
+#include <cstdint>
+#include <cstddef>
+
+struct CTOCEntry;
+
+// Column-oriented storage for the CArchive Table of Contents
+class TocTable {
+public:
+    // Lightweight view of a single row, with the same accessors as CTOCEntry
+    class Entry {
+    public:
+        Entry(const TocTable* table, size_t index) : table(table), row(index) {}
+
+        // Getters for entry details
+        size_t index() const {
+            return row;
+        }
+
+        uint64_t getPosition() const {
+            return table->positionCol[row];
+        }
+
+        uint32_t getCompressedDataSize() const {
+            return table->cmprsdSizeCol[row];
+        }
+
+        uint32_t getUncompressedDataSize() const {
+            return table->uncmprsdSizeCol[row];
+        }
+
+        uint8_t getCompressionFlag() const {
+            return table->flagCol[row];
+        }
+
+        char getType() const {
+            return table->typeCol[row];
+        }
+
+        std::string_view getName() const {
+            return table->name(row);
+        }
+
+        CTOCEntry toEntry() const;
+
+    private:
+        const TocTable* table;     // Table the row belongs to
+        size_t row;                // Row index
+    };
+
+    // Iterator producing Entry views in TOC order
+    class const_iterator {
+    public:
+        const_iterator(const TocTable* table, size_t index) : table(table), row(index) {}
+        Entry operator*() const { return Entry(table, row); }
+        const_iterator& operator++() { ++row; return *this; }
+        bool operator==(const const_iterator& other) const { return row == other.row; }
+        bool operator!=(const const_iterator& other) const { return row != other.row; }
+
+    private:
+        const TocTable* table;
+        size_t row;
+    };
+
+    // Returned by find() when no entry has the requested name
+    static const size_t npos = static_cast<size_t>(-1);
+
+    // Member functions
+    void clear();
+    void reserve(size_t entries, size_t nameBytes);
+    void add(uint64_t position, uint32_t cmprsdSize, uint32_t uncmprsdSize, uint8_t flag, char type, std::string_view name);
+    size_t find(std::string_view name) const;
+    static uint64_t hashName(std::string_view name);
+
+    size_t size() const {
+        return typeCol.size();
+    }
+
+    bool empty() const {
+        return typeCol.empty();
+    }
+
+    Entry operator[](size_t index) const {
+        return Entry(this, index);
+    }
+
+    const_iterator begin() const {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const {
+        return const_iterator(this, size());
+    }
+
+    std::string_view name(size_t index) const {
+        return std::string_view(nameBlob.data() + nameOffsets[index], nameOffsets[index + 1] - nameOffsets[index]);
+    }
+
+    // Column getters for scans that only need a subset of the fields
+    const std::vector<uint64_t>& positions() const {
+        return positionCol;
+    }
+
+    const std::vector<uint32_t>& compressedSizes() const {
+        return cmprsdSizeCol;
+    }
+
+    const std::vector<uint32_t>& uncompressedSizes() const {
+        return uncmprsdSizeCol;
+    }
+
+    const std::vector<uint8_t>& compressionFlags() const {
+        return flagCol;
+    }
+
+    const std::vector<char>& types() const {
+        return typeCol;
+    }
+
+private:
+    void insertIntoIndex(size_t row);
+    void rebuildIndex(size_t slotCount);
+
+    std::vector<uint64_t> positionCol;   // Absolute positions of the entries
+    std::vector<uint32_t> cmprsdSizeCol; // Compressed data sizes
+    std::vector<uint32_t> uncmprsdSizeCol; // Uncompressed data sizes
+    std::vector<uint8_t> flagCol;        // Compression flags
+    std::vector<char> typeCol;           // Types of compressed data
+    std::vector<uint32_t> nameOffsets;   // Start of each name in nameBlob, plus the end offset
+    std::string nameBlob;                // All names stored back to back
+    std::vector<uint64_t> nameHashCol;   // Hash of each name, computed once in add()
+    std::vector<uint32_t> indexSlots;    // Open-addressing name index, row + 1 or 0 if empty
+};
+
+#endif // TOCTABLE_H
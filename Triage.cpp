@@ -0,0 +1,128 @@
+#include "Triage.h"
+#include "MagicScanner.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+const size_t PYINST20_COOKIE_SIZE = 24;
+const size_t PYINST21_COOKIE_SIZE = 24 + 64;
+
+uint32_t readBE32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+        (static_cast<uint32_t>(p[2]) << 8) | static_cast<uint32_t>(p[3]);
+}
+
+/**
+ * @brief Validates the cookie at the end of a tail buffer and fills the result.
+ *
+ * The package must fit in front of the cookie's end, the TOC must lie inside
+ * the package before the cookie, and the Python version must be 2.x or 3.x,
+ * which is enough to reject stray magic bytes without touching the TOC.
+ */
+void checkCookie(const uint8_t* tail, size_t tailLen, uint64_t tailPos, TriageResult& result) {
+    const uint8_t* magic = findLastMagic(tail, tailLen);
+    if (magic == nullptr) {
+        result.verdict = TriageVerdict::NotPyInstaller;
+        return;
+    }
+    result.verdict = TriageVerdict::Corrupt;
+    size_t offset = magic - tail;
+    result.cookiePos = tailPos + offset;
+    if (tailLen - offset < PYINST20_COOKIE_SIZE) {
+        return;
+    }
+
+    // Same test as PyInstArchive::checkFile(): 2.1+ cookies carry the Python library name
+    size_t nameLen = std::min(tailLen - offset - PYINST20_COOKIE_SIZE, PYINST21_COOKIE_SIZE - PYINST20_COOKIE_SIZE);
+    const uint8_t* name = magic + PYINST20_COOKIE_SIZE;
+    bool hasName = std::search(name, name + nameLen, "python", "python" + 6) != name + nameLen;
+    result.pyinstVer = hasName ? 21 : 20;
+    size_t cookieSize = hasName ? PYINST21_COOKIE_SIZE : PYINST20_COOKIE_SIZE;
+    if (tailLen - offset < cookieSize) {
+        return;
+    }
+
+    uint32_t lengthofPackage = readBE32(magic + 8);
+    uint32_t toc = readBE32(magic + 12);
+    uint32_t tocLen = readBE32(magic + 16);
+    uint32_t pyver = readBE32(magic + 20);
+    uint64_t cookieEnd = result.cookiePos + cookieSize;
+    if (lengthofPackage < cookieSize || lengthofPackage > cookieEnd ||
+        static_cast<uint64_t>(toc) + tocLen > lengthofPackage - cookieSize) {
+        return;
+    }
+    uint32_t pymaj = pyver >= 100 ? pyver / 100 : pyver / 10;
+    uint32_t pymin = pyver >= 100 ? pyver % 100 : pyver % 10;
+    if (pymaj < 2 || pymaj > 3) {
+        return;
+    }
+
+    result.verdict = TriageVerdict::PyInstaller;
+    result.pymaj = static_cast<uint8_t>(pymaj);
+    result.pymin = static_cast<uint8_t>(pymin);
+    result.overlaySize = lengthofPackage + (result.fileSize - cookieEnd);
+    result.overlayPos = result.fileSize - result.overlaySize;
+}
+
+} // namespace
+
+/**
+ * @brief Decides whether a file is a PyInstaller binary from its header and tail only.
+ *
+ * The file is opened without mapping it, and at most two positioned reads
+ * are issued: EXECUTABLE_HEADER_PROBE_SIZE bytes from the start, and
+ * `options.tailWindow` bytes from the end. Files smaller than the window
+ * take a single read. With `options.requireExecutable`, files that are
+ * not PE, ELF or Mach-O are rejected after the first read. The cookie fields
+ * are range-checked, but the TOC is never read, so the verdict costs the
+ * same for every archive size.
+ *
+ * Cookies further from the end than the window, for example behind a large
+ * appended signature, are reported as NotPyInstaller; checkFile() finds them.
+ *
+ * @param path File to check.
+ * @param options Tail window and executable requirement.
+ * @return The verdict with the format, versions and overlay range when known.
+ */
+TriageResult triageFile(const std::string& path, const TriageOptions& options) {
+    TriageResult result;
+    MappedFile file;
+    if (!file.open(path)) {
+        return result;
+    }
+    result.fileSize = file.size();
+
+    size_t window = static_cast<size_t>(std::min<uint64_t>(result.fileSize, std::max(options.tailWindow, EXECUTABLE_HEADER_PROBE_SIZE)));
+    std::vector<uint8_t> tail(window);
+    uint64_t tailPos = result.fileSize - window;
+    if (tailPos == 0) {
+        if (!file.readAt(0, tail.data(), window)) {
+            return result;
+        }
+        result.format = detectExecutableFormat(tail.data(), std::min(window, EXECUTABLE_HEADER_PROBE_SIZE));
+    }
+    else {
+        uint8_t head[EXECUTABLE_HEADER_PROBE_SIZE];
+        if (!file.readAt(0, head, sizeof(head))) {
+            return result;
+        }
+        result.format = detectExecutableFormat(head, sizeof(head));
+        if (result.format == ExecutableFormat::Unknown && options.requireExecutable) {
+            result.verdict = TriageVerdict::NotPyInstaller;
+            return result;
+        }
+        if (!file.readAt(tailPos, tail.data(), window)) {
+            return result;
+        }
+    }
+    if (result.format == ExecutableFormat::Unknown && options.requireExecutable) {
+        result.verdict = TriageVerdict::NotPyInstaller;
+        return result;
+    }
+
+    checkCookie(tail.data(), window, tailPos, result);
+    return result;
+}
@@ -0,0 +1,39 @@
+#ifndef TRIAGE_H
+#define TRIAGE_H
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include "ExecutableFormat.h"
+
+// Answer of a triage check
+enum class TriageVerdict {
+    PyInstaller,                   // Valid cookie in the tail window
+    NotPyInstaller,                // No cookie, or not an executable when one is required
+    Corrupt,                       // Cookie found but its fields are out of range
+    Unreadable                     // File could not be opened or read
+};
+
+// Settings for triageFile()
+struct TriageOptions {
+    size_t tailWindow = 64 * 1024; // Bytes read from the end of the file; covers appended code signatures
+    bool requireExecutable = true; // Reject files without a PE, ELF or Mach-O header before reading the tail
+};
+
+// Outcome of a triage check; fields past `format` are only set for PyInstaller and Corrupt verdicts
+struct TriageResult {
+    TriageVerdict verdict = TriageVerdict::Unreadable; // The answer
+    ExecutableFormat format = ExecutableFormat::Unknown; // Executable format from the header
+    uint64_t fileSize = 0;         // Size of the file
+    uint8_t pyinstVer = 0;         // PyInstaller version (20 or 21)
+    uint8_t pymaj = 0;             // Python major version
+    uint8_t pymin = 0;             // Python minor version
+    uint64_t cookiePos = 0;        // Position of the cookie
+    uint64_t overlayPos = 0;       // Start of the CArchive
+    uint64_t overlaySize = 0;      // Size of the CArchive
+};
+
+// Decides whether a file is a PyInstaller binary from its header and tail only
+TriageResult triageFile(const std::string& path, const TriageOptions& options = TriageOptions());
+
+#endif // TRIAGE_H
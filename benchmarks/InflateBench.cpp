@@ -0,0 +1,94 @@
+#include <zlib.h>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+#include "../Decompressor.h"
+#include "Bench.h"
+
+namespace {
+
+// A compressed payload with the size and redundancy of a typical entry
+struct Payload {
+    const char* label;             // Description printed with the results
+    std::vector<uint8_t> plain;    // Uncompressed bytes
+    std::vector<uint8_t> packed;   // zlib stream at level 9, as PyInstaller writes it
+};
+
+// Marshalled bytecode: short opcodes mixed with names from a small vocabulary
+std::vector<uint8_t> makeModule(size_t size, std::mt19937& random) {
+    static const char* const names[] = { "self", "value", "result", "__init__", "append", "items", "os.path", "logging", "return", "None" };
+    std::vector<uint8_t> out;
+    while (out.size() < size) {
+        out.push_back(static_cast<uint8_t>(random() % 160));
+        out.push_back(static_cast<uint8_t>(random() % 32));
+        const char* name = names[random() % 10];
+        out.insert(out.end(), name, name + std::char_traits<char>::length(name));
+    }
+    out.resize(size);
+    return out;
+}
+
+// Machine code and tables: mostly random bytes with runs of zero padding
+std::vector<uint8_t> makeLibrary(size_t size, std::mt19937& random) {
+    std::vector<uint8_t> out(size);
+    for (size_t i = 0; i < size; ++i) {
+        out[i] = (i / 64) % 3 == 0 ? 0 : static_cast<uint8_t>(random() % 64);
+    }
+    return out;
+}
+
+Payload pack(const char* label, std::vector<uint8_t> plain) {
+    Payload payload{ label, std::move(plain), {} };
+    uLongf packedLen = compressBound(static_cast<uLong>(payload.plain.size()));
+    payload.packed.resize(packedLen);
+    compress2(payload.packed.data(), &packedLen, payload.plain.data(), static_cast<uLong>(payload.plain.size()), 9);
+    payload.packed.resize(packedLen);
+    return payload;
+}
+
+} // namespace
+
+/**
+ * @brief Compares the compiled-in inflate backends on entry-sized payloads.
+ *
+ * Each backend inflates module-sized (4 KiB, 64 KiB) and library-sized
+ * (1 MiB, 16 MiB) zlib streams with inflateBuffer(), as done for entries
+ * whose uncompressed size is known; output is checked against the input.
+ * Throughput is uncompressed bytes per second, fastest of several runs.
+ *
+ * Usage: InflateBench
+ */
+int main() {
+    std::mt19937 random(1);
+    std::vector<Payload> payloads;
+    payloads.push_back(pack("module 4 KiB", makeModule(4 << 10, random)));
+    payloads.push_back(pack("module 64 KiB", makeModule(64 << 10, random)));
+    payloads.push_back(pack("library 1 MiB", makeLibrary(1 << 20, random)));
+    payloads.push_back(pack("library 16 MiB", makeLibrary(16 << 20, random)));
+
+    for (InflateBackend backend : { InflateBackend::Zlib, InflateBackend::Libdeflate }) {
+        if (!isInflateBackendAvailable(backend)) {
+            continue;
+        }
+        std::unique_ptr<Decompressor> decompressor = createDecompressor(backend);
+        for (const Payload& payload : payloads) {
+            std::vector<uint8_t> out(payload.plain.size());
+            size_t repeat = std::max<size_t>(1, (64 << 20) / payload.plain.size());
+            bool ok = true;
+            double seconds = bestSeconds(3, [&] {
+                for (size_t i = 0; i < repeat; ++i) {
+                    ok = decompressor->inflateBuffer(payload.packed.data(), payload.packed.size(), out.data(), out.size()) && ok;
+                }
+            });
+            if (!ok || out != payload.plain) {
+                std::fprintf(stderr, "%s failed on %s\n", decompressor->name(), payload.label);
+                return 1;
+            }
+            std::printf("%-10s  %-15s  ratio %4.2f  %8.1f MB/s\n", decompressor->name(), payload.label,
+                double(payload.packed.size()) / payload.plain.size(), payload.plain.size() * repeat / seconds / 1e6);
+        }
+    }
+    return 0;
+}
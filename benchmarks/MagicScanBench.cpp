@@ -0,0 +1,62 @@
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "../MagicScanner.h"
+#include "../MappedFile.h"
+#include "Bench.h"
+
+/**
+ * @brief Measures the backward cookie scan over a buffer without a cookie.
+ *
+ * This is the worst case of checkFile(): a large file that is not a
+ * PyInstaller archive is searched from end to start. The vectorized scanner
+ * is compared with the scalar reference and with the former approach of
+ * copying 8 KiB chunks into a string and calling rfind().
+ *
+ * Usage: MagicScanBench [sizeMiB | file]
+ */
+int main(int argc, char* argv[]) {
+    std::vector<uint8_t> owned;
+    MappedFile file;
+    const uint8_t* data = nullptr;
+    size_t size = 0;
+    if (argc > 1 && file.open(argv[1]) && file.map()) {
+        data = file.data();
+        size = static_cast<size_t>(file.size());
+    }
+    else {
+        size_t mib = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 256;
+        owned.resize(mib << 20);
+        std::mt19937 random(1);
+        for (uint8_t& byte : owned) {
+            byte = static_cast<uint8_t>(random() % 0x4d);  // Never 'M', so no cookie
+        }
+        data = owned.data();
+        size = owned.size();
+    }
+
+    const std::string magic = "MEI\014\013\012\013\016";
+    const uint8_t* found = nullptr;
+    double vectorized = bestSeconds(5, [&] { found = findLastMagic(data, size); });
+    double scalar = bestSeconds(5, [&] { found = findLastMagicScalar(data, size); });
+    double chunked = bestSeconds(5, [&] {
+        std::string chunk;
+        for (size_t end = size; end > 0;) {
+            size_t start = end > 8192 ? end - 8192 : 0;
+            chunk.assign(reinterpret_cast<const char*>(data) + start, end - start);
+            if (chunk.rfind(magic) != std::string::npos) {
+                break;
+            }
+            end = start == 0 ? 0 : start + magic.size() - 1;
+        }
+    });
+
+    double gb = size / 1e9;
+    std::printf("%zu bytes, cookie %s\n", size, found != nullptr ? "found" : "not found");
+    std::printf("findLastMagic        %8.2f GB/s\n", gb / vectorized);
+    std::printf("findLastMagicScalar  %8.2f GB/s\n", gb / scalar);
+    std::printf("8 KiB chunks + rfind %8.2f GB/s\n", gb / chunked);
+    return 0;
+}
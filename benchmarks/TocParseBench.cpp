@@ -0,0 +1,78 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "../Logger.h"
+#include "../MagicScanner.h"
+#include "../PyInstArchive.h"
+#include "Bench.h"
+
+namespace {
+
+void appendUInt32BE(std::vector<uint8_t>& out, uint32_t value) {
+    uint8_t bytes[4] = { static_cast<uint8_t>(value >> 24), static_cast<uint8_t>(value >> 16), static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value) };
+    out.insert(out.end(), bytes, bytes + 4);
+}
+
+// Builds a PyInstaller 2.1 CArchive of empty module entries named like real ones
+std::vector<uint8_t> buildArchive(size_t entries) {
+    std::vector<uint8_t> archive;
+    char name[32];
+    for (size_t i = 0; i < entries; ++i) {
+        int nameLen = std::snprintf(name, sizeof(name), "pkg/module_%07zu", i);
+        uint32_t entrySize = 18 + ((nameLen + 16) & ~15);  // Name padded with at least one NUL
+        appendUInt32BE(archive, entrySize);
+        appendUInt32BE(archive, 0);
+        appendUInt32BE(archive, 0);
+        appendUInt32BE(archive, 0);
+        archive.push_back(0);
+        archive.push_back('m');
+        archive.insert(archive.end(), name, name + nameLen);
+        archive.resize(archive.size() + entrySize - 18 - nameLen);
+    }
+    uint32_t tocLen = static_cast<uint32_t>(archive.size());
+    const char magic[] = "MEI\014\013\012\013\016";
+    archive.insert(archive.end(), magic, magic + MAGIC_SIZE);
+    appendUInt32BE(archive, tocLen + 24 + 64);
+    appendUInt32BE(archive, 0);
+    appendUInt32BE(archive, tocLen);
+    appendUInt32BE(archive, 311);
+    const char pylib[64] = "python311.dll";
+    archive.insert(archive.end(), pylib, pylib + sizeof(pylib));
+    return archive;
+}
+
+} // namespace
+
+/**
+ * @brief Measures parseTOC() on synthetic tables of contents.
+ *
+ * Archives of 1k, 100k and 1M entries are built in memory and their cookie
+ * and TOC are decoded with getCArchiveInfo(); the fastest of several runs is
+ * reported per archive.
+ *
+ * Usage: TocParseBench [entries...]
+ */
+int main(int argc, char* argv[]) {
+    setLogLevel(LogLevel::Error);
+    std::vector<size_t> counts = { 1000, 100000, 1000000 };
+    if (argc > 1) {
+        counts.clear();
+        for (int i = 1; i < argc; ++i) {
+            counts.push_back(std::strtoull(argv[i], nullptr, 10));
+        }
+    }
+
+    for (size_t count : counts) {
+        std::vector<uint8_t> data = buildArchive(count);
+        PyInstArchive archive(data.data(), data.size(), "synthetic");
+        if (!archive.checkFile() || !archive.getCArchiveInfo() || archive.getTOC().size() != count) {
+            std::fprintf(stderr, "Could not parse the synthetic archive of %zu entries\n", count);
+            return 1;
+        }
+        double seconds = bestSeconds(5, [&] { archive.getCArchiveInfo(); });
+        std::printf("%8zu entries  %10.1f us  %6.1f ns/entry\n", count, seconds * 1e6, seconds * 1e9 / count);
+    }
+    return 0;
+}